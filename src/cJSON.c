@@ -57,6 +57,8 @@
 #endif
 
 #include "cJSON.h"
+#include "jindex.h"
+#include "numparse.h"
 
 /* define our own boolean type */
 #ifdef true
@@ -90,7 +92,17 @@ typedef struct {
     const unsigned char *json;
     size_t position;
 } error;
-static error global_error = {NULL, 0};
+
+/* streams are parsed on several threads at once, each sees its own error */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) &&             \
+    !defined(__STDC_NO_THREADS__)
+#define CJSON_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define CJSON_THREAD_LOCAL __thread
+#else
+#define CJSON_THREAD_LOCAL
+#endif
+static CJSON_THREAD_LOCAL error global_error = {NULL, 0};
 
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void) {
     return (const char *)(global_error.json + global_error.position);
@@ -152,6 +164,9 @@ typedef struct internal_hooks {
     void *(CJSON_CDECL *allocate)(size_t size);
     void(CJSON_CDECL *deallocate)(void *pointer);
     void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    /* when set, items and strings created while parsing are bump allocated
+     * from here and never individually freed */
+    cJSON_Arena *arena;
 } internal_hooks;
 
 #if defined(_MSC_VER)
@@ -176,7 +191,252 @@ static void *CJSON_CDECL internal_realloc(void *pointer, size_t size) {
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
 static internal_hooks global_hooks = {
-    internal_malloc, internal_free, internal_realloc};
+    internal_malloc, internal_free, internal_realloc, NULL};
+
+/* Arena allocation: memory is carved out of large blocks and only ever
+ * released all at once, either by rewinding the arena for reuse or deleting
+ * it. Items parsed into an arena sit next to each other in memory. */
+typedef struct arena_block {
+    struct arena_block *next;
+    size_t size; /* usable bytes after the header */
+    size_t used;
+} arena_block;
+
+/* Open addressed set of the object member names parsed into an arena. The
+ * names are allocated with the global hooks so rewinding the arena keeps
+ * them. */
+typedef struct arena_keys {
+    size_t mask; /* the slot count is a power of two */
+    size_t count;
+    char *slots[1];
+} arena_keys;
+
+struct cJSON_Arena {
+    arena_block *head;
+    arena_block *current; /* block allocations are currently served from */
+    arena_block *tail;
+    size_t block_size;
+    arena_keys *keys;
+};
+
+/* FNV-1a */
+static unsigned int hash_key(const unsigned char *key, size_t length) {
+    unsigned int hash = 2166136261U;
+    size_t i = 0;
+
+    for (i = 0; i < length; i++) {
+        hash ^= key[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+#define ARENA_ALIGNMENT sizeof(double)
+#define arena_align(size)                                                      \
+    (((size) + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1))
+#define ARENA_HEADER_SIZE arena_align(sizeof(arena_block))
+#define arena_block_data(block) ((unsigned char *)(block) + ARENA_HEADER_SIZE)
+
+static void *arena_allocate(cJSON_Arena *const arena, size_t size) {
+    arena_block *block = arena->current;
+    void *allocation = NULL;
+
+    size = arena_align(size);
+
+    /* blocks after the current one are only non-empty when the arena has been
+     * reset, reuse them before asking for more memory */
+    while ((block != NULL) && (block->used + size > block->size)) {
+        block = block->next;
+    }
+
+    if (block == NULL) {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+
+        block = (arena_block *)global_hooks.allocate(
+            ARENA_HEADER_SIZE + block_size);
+        if (block == NULL) {
+            return NULL;
+        }
+
+        block->next = NULL;
+        block->size = block_size;
+        block->used = 0;
+
+        if (arena->tail == NULL) {
+            arena->head = block;
+        } else {
+            arena->tail->next = block;
+        }
+        arena->tail = block;
+    }
+
+    arena->current = block;
+    allocation = arena_block_data(block) + block->used;
+    block->used += size;
+
+    return allocation;
+}
+
+CJSON_PUBLIC(cJSON_Arena *) cJSON_ArenaCreate(size_t block_size) {
+    cJSON_Arena *arena =
+        (cJSON_Arena *)global_hooks.allocate(sizeof(cJSON_Arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    arena->head = arena->current = arena->tail = NULL;
+    arena->block_size = block_size == 0 ? CJSON_ARENA_BLOCK_SIZE : block_size;
+    arena->keys = NULL;
+
+    return arena;
+}
+
+CJSON_PUBLIC(void) cJSON_ArenaReset(cJSON_Arena *arena) {
+    arena_block *block = NULL;
+
+    if (arena == NULL) {
+        return;
+    }
+
+    for (block = arena->head; block != NULL; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = arena->head;
+}
+
+CJSON_PUBLIC(void) cJSON_ArenaDelete(cJSON_Arena *arena) {
+    arena_block *block = NULL;
+    arena_block *next = NULL;
+
+    if (arena == NULL) {
+        return;
+    }
+
+    for (block = arena->head; block != NULL; block = next) {
+        next = block->next;
+        global_hooks.deallocate(block);
+    }
+    if (arena->keys != NULL) {
+        size_t i = 0;
+
+        for (i = 0; i <= arena->keys->mask; i++) {
+            if (arena->keys->slots[i] != NULL) {
+                global_hooks.deallocate(arena->keys->slots[i]);
+            }
+        }
+        global_hooks.deallocate(arena->keys);
+    }
+    global_hooks.deallocate(arena);
+}
+
+static arena_keys *arena_keys_create(size_t slots) {
+    arena_keys *keys = (arena_keys *)global_hooks.allocate(
+        sizeof(arena_keys) + (slots - 1) * sizeof(char *));
+    if (keys == NULL) {
+        return NULL;
+    }
+
+    keys->mask = slots - 1;
+    keys->count = 0;
+    memset(keys->slots, '\0', slots * sizeof(char *));
+
+    return keys;
+}
+
+/* Grow the set so it stays at most half full */
+static cJSON_bool arena_keys_reserve(cJSON_Arena *const arena) {
+    arena_keys *keys = arena->keys;
+    arena_keys *grown = NULL;
+    size_t i = 0;
+    size_t j = 0;
+
+    if (keys == NULL) {
+        return (arena->keys = arena_keys_create(64)) != NULL;
+    }
+    if ((keys->count + 1) * 2 <= keys->mask + 1) {
+        return true;
+    }
+
+    grown = arena_keys_create((keys->mask + 1) * 2);
+    if (grown == NULL) {
+        return false;
+    }
+    for (i = 0; i <= keys->mask; i++) {
+        if (keys->slots[i] == NULL) {
+            continue;
+        }
+        j = hash_key((const unsigned char *)keys->slots[i],
+                strlen(keys->slots[i])) &
+            grown->mask;
+        while (grown->slots[j] != NULL) {
+            j = (j + 1) & grown->mask;
+        }
+        grown->slots[j] = keys->slots[i];
+    }
+    grown->count = keys->count;
+    global_hooks.deallocate(keys);
+    arena->keys = grown;
+
+    return true;
+}
+
+/* The arena's copy of the name `length` bytes long at `name`, made on first
+ * sight. NULL once the arena holds CJSON_INTERN_LIMIT names or when out of
+ * memory. */
+static char *arena_intern(
+    cJSON_Arena *const arena, const unsigned char *name, size_t length) {
+    unsigned int hash = hash_key(name, length);
+    char *copy = NULL;
+    size_t i = 0;
+
+    if (arena->keys != NULL) {
+        for (i = hash & arena->keys->mask; arena->keys->slots[i] != NULL;
+             i = (i + 1) & arena->keys->mask) {
+            const char *key = arena->keys->slots[i];
+            if ((strncmp(key, (const char *)name, length) == 0) &&
+                (key[length] == '\0')) {
+                return arena->keys->slots[i];
+            }
+        }
+        if (arena->keys->count >= CJSON_INTERN_LIMIT) {
+            return NULL;
+        }
+    }
+
+    if (!arena_keys_reserve(arena)) {
+        return NULL;
+    }
+    copy = (char *)global_hooks.allocate(length + sizeof(""));
+    if (copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, name, length);
+    copy[length] = '\0';
+
+    for (i = hash & arena->keys->mask; arena->keys->slots[i] != NULL;
+         i = (i + 1) & arena->keys->mask) {
+    }
+    arena->keys->slots[i] = copy;
+    arena->keys->count++;
+
+    return copy;
+}
+
+/* Allocate from the arena if the hooks have one */
+static void *hooks_allocate(const internal_hooks *const hooks, size_t size) {
+    if (hooks->arena != NULL) {
+        return arena_allocate(hooks->arena, size);
+    }
+
+    return hooks->allocate(size);
+}
+
+static void hooks_deallocate(const internal_hooks *const hooks, void *pointer) {
+    if (hooks->arena == NULL) {
+        hooks->deallocate(pointer);
+    }
+}
 
 static unsigned char *cJSON_strdup(
     const unsigned char *string, const internal_hooks *const hooks) {
@@ -198,6 +458,8 @@ static unsigned char *cJSON_strdup(
 }
 
 CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks *hooks) {
+    global_hooks.arena = NULL;
+
     if (hooks == NULL) {
         /* Reset hooks */
         global_hooks.allocate = malloc;
@@ -226,7 +488,7 @@ CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks *hooks) {
 
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks *const hooks) {
-    cJSON *node = (cJSON *)hooks->allocate(sizeof(cJSON));
+    cJSON *node = (cJSON *)hooks_allocate(hooks, sizeof(cJSON));
     if (node) {
         memset(node, '\0', sizeof(cJSON));
     }
@@ -237,11 +499,18 @@ static cJSON *cJSON_New_Item(const internal_hooks *const hooks) {
 /* Delete a cJSON structure. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item) {
     cJSON *next = NULL;
+    /* the whole document lives in an arena and goes away with it */
+    if ((item != NULL) && (item->type & cJSON_ArenaOwned)) {
+        return;
+    }
     while (item != NULL) {
         next = item->next;
         if (!(item->type & cJSON_IsReference) && (item->child != NULL)) {
             cJSON_Delete(item->child);
         }
+        if (!(item->type & cJSON_IsReference) && (item->index != NULL)) {
+            global_hooks.deallocate(item->index);
+        }
         if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL)) {
             global_hooks.deallocate(item->valuestring);
         }
@@ -284,6 +553,122 @@ typedef struct {
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* Items that failed to parse are only freed if they did not come from an
+ * arena, they have not been marked as arena owned yet */
+static void parse_delete(parse_buffer *const input_buffer, cJSON *item) {
+    if (input_buffer->hooks.arena == NULL) {
+        cJSON_Delete(item);
+    }
+}
+
+/* An array's index holds its items in order. An object's is an open
+ * addressed hash table of its members, each slot holding the first member
+ * with its key so a lookup finds the same item a linear search would even
+ * when keys are repeated. */
+struct cJSON_Index {
+    size_t count; /* items or members */
+    size_t mask;  /* objects only, the slot count is a power of two */
+    cJSON *slots[1];
+};
+
+#define has_array_index(item)                                                  \
+    (((item)->index != NULL) && (((item)->type & 0xFF) == cJSON_Array))
+#define has_object_index(item)                                                 \
+    (((item)->index != NULL) && (((item)->type & 0xFF) == cJSON_Object))
+
+/* Build the index of an array with `count` items. Failing to allocate is not
+ * an error, the items are walked instead. */
+static void array_index_build(
+    cJSON *const array, size_t count, const internal_hooks *const hooks) {
+    struct cJSON_Index *index = NULL;
+    cJSON *child = NULL;
+    size_t i = 0;
+
+    index = (struct cJSON_Index *)hooks_allocate(
+        hooks, sizeof(struct cJSON_Index) + (count - 1) * sizeof(cJSON *));
+    if (index == NULL) {
+        return;
+    }
+    index->count = count;
+    index->mask = 0;
+
+    for (child = array->child; child != NULL; child = child->next) {
+        index->slots[i++] = child;
+    }
+
+    array->index = index;
+}
+
+/* Build the index of an object with `count` members. Failing to allocate is
+ * not an error, lookups search the members linearly instead. */
+static void object_index_build(
+    cJSON *const object, size_t count, const internal_hooks *const hooks) {
+    struct cJSON_Index *index = NULL;
+    cJSON *child = NULL;
+    size_t slots = 1;
+    size_t i = 0;
+
+    /* at most half full */
+    while (slots < count * 2) {
+        slots <<= 1;
+    }
+
+    index = (struct cJSON_Index *)hooks_allocate(
+        hooks, sizeof(struct cJSON_Index) + (slots - 1) * sizeof(cJSON *));
+    if (index == NULL) {
+        return;
+    }
+    index->count = count;
+    index->mask = slots - 1;
+    memset(index->slots, '\0', slots * sizeof(cJSON *));
+
+    for (child = object->child; child != NULL; child = child->next) {
+        i = hash_key((const unsigned char *)child->string,
+                strlen(child->string)) &
+            index->mask;
+        while ((index->slots[i] != NULL) &&
+               (index->slots[i]->string != child->string) &&
+               (strcmp(index->slots[i]->string, child->string) != 0)) {
+            i = (i + 1) & index->mask;
+        }
+        if (index->slots[i] == NULL) {
+            index->slots[i] = child;
+        }
+    }
+
+    object->index = index;
+}
+
+static cJSON *object_index_find(
+    const struct cJSON_Index *const index, const char *const name) {
+    size_t i =
+        hash_key((const unsigned char *)name, strlen(name)) & index->mask;
+
+    while (index->slots[i] != NULL) {
+        /* interned names are found by their address */
+        if ((index->slots[i]->string == name) ||
+            (strcmp(index->slots[i]->string, name) == 0)) {
+            return index->slots[i];
+        }
+        i = (i + 1) & index->mask;
+    }
+
+    return NULL;
+}
+
+/* The items of `parent` are about to change */
+static void index_drop(cJSON *const parent) {
+    if ((parent == NULL) || (parent->index == NULL)) {
+        return;
+    }
+
+    /* an arena owned index goes away with the arena */
+    if (!(parent->type & (cJSON_ArenaOwned | cJSON_IsReference))) {
+        global_hooks.deallocate(parent->index);
+    }
+    parent->index = NULL;
+}
+
 /* Parse the input text to generate a number, and populate the result into item.
  */
 static cJSON_bool parse_number(
@@ -291,13 +676,24 @@ static cJSON_bool parse_number(
     double number = 0;
     unsigned char *after_end = NULL;
     unsigned char number_c_string[64];
-    unsigned char decimal_point = get_decimal_point();
+    unsigned char decimal_point = 0;
     size_t i = 0;
+    size_t length = 0;
 
     if ((input_buffer == NULL) || (input_buffer->content == NULL)) {
         return false;
     }
 
+    /* exact fast paths straight off the input, anything they cannot handle
+     * falls through to strtod below */
+    length = numparseDouble((const char *)buffer_at_offset(input_buffer),
+        input_buffer->length - input_buffer->offset, &number);
+    if (length != 0) {
+        goto number_done;
+    }
+
+    decimal_point = get_decimal_point();
+
     /* copy the number into a temporary buffer and replace '.' with the decimal
      * point of the current locale (for strtod)
      * This also takes care of '\0' not necessarily being available for marking
@@ -338,7 +734,9 @@ loop_end:
     if (number_c_string == after_end) {
         return false; /* parse_error */
     }
+    length = (size_t)(after_end - number_c_string);
 
+number_done:
     item->valuedouble = number;
 
     /* use saturation in case of overflow */
@@ -352,7 +750,7 @@ loop_end:
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
+    input_buffer->offset += length;
     return true;
 }
 
@@ -728,8 +1126,8 @@ static cJSON_bool parse_string(
         allocation_length =
             (size_t)(input_end - buffer_at_offset(input_buffer)) -
             skipped_bytes;
-        output = (unsigned char *)input_buffer->hooks.allocate(
-            allocation_length + sizeof(""));
+        output = (unsigned char *)hooks_allocate(
+            &input_buffer->hooks, allocation_length + sizeof(""));
         if (output == NULL) {
             goto fail; /* allocation failure */
         }
@@ -800,7 +1198,7 @@ static cJSON_bool parse_string(
 
 fail:
     if (output != NULL) {
-        input_buffer->hooks.deallocate(output);
+        hooks_deallocate(&input_buffer->hooks, output);
     }
 
     if (input_pointer != NULL) {
@@ -810,6 +1208,44 @@ fail:
     return false;
 }
 
+/* Parse the name of an object member into item->string. When parsing into an
+ * arena the name is looked up straight from the input, and a name seen before
+ * is not copied again. */
+static cJSON_bool parse_key(
+    cJSON *const item, parse_buffer *const input_buffer) {
+    const unsigned char *name = buffer_at_offset(input_buffer) + 1;
+    const unsigned char *end = name;
+    const unsigned char *input_end =
+        input_buffer->content + input_buffer->length;
+
+    if ((input_buffer->hooks.arena != NULL) &&
+        (buffer_at_offset(input_buffer)[0] == '\"')) {
+        /* names with escapes take the slow path */
+        while ((end < input_end) && (*end != '\"') && (*end != '\\')) {
+            end++;
+        }
+        if ((end < input_end) && (*end == '\"')) {
+            item->string = arena_intern(
+                input_buffer->hooks.arena, name, (size_t)(end - name));
+            if (item->string != NULL) {
+                input_buffer->offset =
+                    (size_t)(end - input_buffer->content) + 1;
+                return true;
+            }
+        }
+    }
+
+    if (!parse_string(item, input_buffer)) {
+        return false;
+    }
+
+    /* swap valuestring and string, because we parsed the name */
+    item->string = item->valuestring;
+    item->valuestring = NULL;
+
+    return true;
+}
+
 /* Render the cstring provided to an escaped version that can be printed. */
 static cJSON_bool print_string_ptr(
     const unsigned char *const input, printbuffer *const output_buffer) {
@@ -929,6 +1365,8 @@ static cJSON_bool print_string(const cJSON *const item, printbuffer *const p) {
 /* Predeclare these prototypes. */
 static cJSON_bool parse_value(
     cJSON *const item, parse_buffer *const input_buffer);
+static cJSON_bool parse_value_type(
+    cJSON *const item, parse_buffer *const input_buffer);
 static cJSON_bool print_value(
     const cJSON *const item, printbuffer *const output_buffer);
 static cJSON_bool parse_array(
@@ -995,10 +1433,10 @@ cJSON_ParseWithOpts(const char *value, const char **return_parse_end,
 }
 
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *)
-cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length,
-    const char **return_parse_end, cJSON_bool require_null_terminated) {
-    parse_buffer buffer = {0, 0, 0, 0, {0, 0, 0}};
+static cJSON *parse_with_hooks(const char *value, size_t buffer_length,
+    const char **return_parse_end, cJSON_bool require_null_terminated,
+    const internal_hooks *const hooks) {
+    parse_buffer buffer = {0, 0, 0, 0, {0, 0, 0, 0}};
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1012,9 +1450,9 @@ cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length,
     buffer.content = (const unsigned char *)value;
     buffer.length = buffer_length;
     buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    buffer.hooks = *hooks;
 
-    item = cJSON_New_Item(&global_hooks);
+    item = cJSON_New_Item(hooks);
     if (item == NULL) /* memory fail */
     {
         goto fail;
@@ -1042,7 +1480,7 @@ cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length,
 
 fail:
     if (item != NULL) {
-        cJSON_Delete(item);
+        parse_delete(&buffer, item);
     }
 
     if (value != NULL) {
@@ -1067,6 +1505,26 @@ fail:
     return NULL;
 }
 
+CJSON_PUBLIC(cJSON *)
+cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length,
+    const char **return_parse_end, cJSON_bool require_null_terminated) {
+    return parse_with_hooks(value, buffer_length, return_parse_end,
+        require_null_terminated, &global_hooks);
+}
+
+CJSON_PUBLIC(cJSON *)
+cJSON_ParseWithArena(
+    const char *value, size_t buffer_length, cJSON_Arena *arena) {
+    internal_hooks hooks = global_hooks;
+
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    hooks.arena = arena;
+    return parse_with_hooks(value, buffer_length, 0, 0, &hooks);
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value) {
     return cJSON_ParseWithOpts(value, 0, 0);
@@ -1077,6 +1535,646 @@ cJSON_ParseWithLength(const char *value, size_t buffer_length) {
     return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
 }
 
+#define STREAM_START 0    /* opening bracket not yet consumed */
+#define STREAM_ELEMENTS 1 /* between elements of the array */
+#define STREAM_DONE 2     /* closing bracket consumed */
+#define STREAM_FAILED 3   /* parse error, see cJSON_GetErrorPtr */
+#define STREAM_SLICE 4    /* first element of a slice not yet parsed */
+#define STREAM_LINES 5    /* newline delimited values, no enclosing array */
+
+struct cJSON_Stream {
+    parse_buffer buffer;
+    cJSON_Arena *arena; /* rewound for every element */
+    cJSON *current;     /* the element handed out by the last call */
+    int state;
+    cJSON_bool slice; /* the buffer ends where the slice's elements do */
+};
+
+/* Unlike buffer_skip_whitespace this never steps back from the end of the
+ * buffer, so reaching the end can be told apart from a trailing character */
+static void stream_skip_whitespace(parse_buffer *const buffer) {
+    while (can_access_at_index(buffer, 0) &&
+           (buffer_at_offset(buffer)[0] <= 32)) {
+        buffer->offset++;
+    }
+}
+
+static cJSON *stream_fail(cJSON_Stream *stream) {
+    stream->state = STREAM_FAILED;
+    global_error.json = stream->buffer.content;
+    global_error.position = stream->buffer.offset < stream->buffer.length
+                                ? stream->buffer.offset
+                                : stream->buffer.length - 1;
+    return NULL;
+}
+
+/* The closing bracket of the array, only whitespace may follow it */
+static cJSON *stream_end(cJSON_Stream *stream) {
+    stream->buffer.offset++;
+    stream_skip_whitespace(&stream->buffer);
+    if (can_access_at_index(&stream->buffer, 0)) {
+        return stream_fail(stream);
+    }
+    stream->state = STREAM_DONE;
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreate(const char *value, size_t buffer_length) {
+    cJSON_Stream *stream = NULL;
+
+    if ((value == NULL) || (buffer_length == 0)) {
+        return NULL;
+    }
+
+    stream = (cJSON_Stream *)global_hooks.allocate(sizeof(cJSON_Stream));
+    if (stream == NULL) {
+        return NULL;
+    }
+    memset(stream, '\0', sizeof(cJSON_Stream));
+
+    if ((stream->arena = cJSON_ArenaCreate(0)) == NULL) {
+        global_hooks.deallocate(stream);
+        return NULL;
+    }
+
+    stream->buffer.content = (const unsigned char *)value;
+    stream->buffer.length = buffer_length;
+    stream->buffer.hooks = global_hooks;
+    stream->buffer.hooks.arena = stream->arena;
+    stream->state = STREAM_START;
+
+    global_error.json = NULL;
+    global_error.position = 0;
+
+    return stream;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_StreamNext(cJSON_Stream *stream) {
+    parse_buffer *buffer = NULL;
+    size_t start = 0;
+
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    buffer = &stream->buffer;
+
+    /* the previous element's memory is reused for this one */
+    stream->current = NULL;
+    cJSON_ArenaReset(stream->arena);
+
+    switch (stream->state) {
+    case STREAM_START:
+        skip_utf8_bom(buffer);
+        stream_skip_whitespace(buffer);
+        if (cannot_access_at_index(buffer, 0) ||
+            (buffer_at_offset(buffer)[0] != '[')) {
+            return stream_fail(stream); /* not an array */
+        }
+        buffer->offset++;
+        /* the top-level array counts towards the nesting limit */
+        buffer->depth = 1;
+        stream_skip_whitespace(buffer);
+        if (can_access_at_index(buffer, 0) &&
+            (buffer_at_offset(buffer)[0] == ']')) {
+            return stream_end(stream); /* empty array */
+        }
+        stream->state = STREAM_ELEMENTS;
+        break;
+
+    case STREAM_SLICE:
+        stream->state = STREAM_ELEMENTS;
+        break;
+
+    case STREAM_LINES:
+        /* blank lines are skipped */
+        stream_skip_whitespace(buffer);
+        if (cannot_access_at_index(buffer, 0)) {
+            stream->state = STREAM_DONE;
+            return NULL;
+        }
+        if ((stream->current = cJSON_New_Item(&buffer->hooks)) == NULL) {
+            return stream_fail(stream); /* allocation failure */
+        }
+        start = buffer->offset;
+        if (!parse_value(stream->current, buffer)) {
+            stream->current = NULL;
+            return stream_fail(stream);
+        }
+        /* a value may not span lines, so the input can be cut at any '\n' */
+        if (memchr(buffer->content + start, '\n', buffer->offset - start) !=
+            NULL) {
+            stream->current = NULL;
+            return stream_fail(stream);
+        }
+        /* nothing else may follow the value on its line */
+        while (can_access_at_index(buffer, 0) &&
+               (buffer_at_offset(buffer)[0] != '\n') &&
+               (buffer_at_offset(buffer)[0] <= 32)) {
+            buffer->offset++;
+        }
+        if (can_access_at_index(buffer, 0) &&
+            (buffer_at_offset(buffer)[0] != '\n')) {
+            stream->current = NULL;
+            return stream_fail(stream);
+        }
+        return stream->current;
+
+    case STREAM_ELEMENTS:
+        stream_skip_whitespace(buffer);
+        if (cannot_access_at_index(buffer, 0)) {
+            if (stream->slice) {
+                stream->state = STREAM_DONE;
+                return NULL;
+            }
+            return stream_fail(stream); /* expected end of array */
+        }
+        if (buffer_at_offset(buffer)[0] == ']') {
+            return stream_end(stream);
+        }
+        if (buffer_at_offset(buffer)[0] != ',') {
+            return stream_fail(stream);
+        }
+        buffer->offset++;
+        break;
+
+    default:
+        return NULL;
+    }
+
+    stream_skip_whitespace(buffer);
+    if ((stream->current = cJSON_New_Item(&buffer->hooks)) == NULL) {
+        return stream_fail(stream); /* allocation failure */
+    }
+
+    if (!parse_value(stream->current, buffer)) {
+        stream->current = NULL;
+        return stream_fail(stream);
+    }
+
+    return stream->current;
+}
+
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreateLines(const char *value, size_t buffer_length) {
+    cJSON_Stream *stream = NULL;
+
+    if ((stream = cJSON_StreamCreate(value, buffer_length)) == NULL) {
+        return NULL;
+    }
+
+    skip_utf8_bom(&stream->buffer);
+    stream->state = STREAM_LINES;
+
+    return stream;
+}
+
+/* A stream over the elements between `start` and `end`, which must not
+ * include the commas either side of them */
+static cJSON_Stream *stream_create_slice(
+    const char *value, size_t start, size_t end) {
+    cJSON_Stream *stream = NULL;
+
+    if ((stream = cJSON_StreamCreate(value, end)) == NULL) {
+        return NULL;
+    }
+
+    stream->buffer.offset = start;
+    stream->buffer.depth = 1;
+    stream->state = STREAM_SLICE;
+    stream->slice = true;
+
+    return stream;
+}
+
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreateSlice(const char *value, size_t buffer_length) {
+    return stream_create_slice(value, 0, buffer_length);
+}
+
+CJSON_PUBLIC(size_t)
+cJSON_StreamSplit(const char *value, size_t buffer_length, size_t parts,
+    cJSON_Stream **streams, size_t *counts) {
+    const unsigned char *content = (const unsigned char *)value;
+    jindex *idx = NULL;
+    size_t i = 0;
+    size_t bom = 0;
+    size_t start = 0;
+    size_t target = 0;
+    size_t end = 0;
+    size_t created = 0;
+    size_t elements = 0;
+    size_t depth = 0;
+    unsigned char c = 0;
+
+    if ((value == NULL) || (buffer_length == 0) || (parts == 0)) {
+        return 0;
+    }
+
+    if ((buffer_length >= 3) &&
+        (strncmp(value, "\xEF\xBB\xBF", 3) == 0)) {
+        bom = 3;
+    }
+
+    /* stage one of the indexed parser gives every bracket and comma that is
+     * not inside a string */
+    if ((idx = jindexBuild(value + bom, buffer_length - bom)) == NULL) {
+        return 0;
+    }
+
+    if ((idx->count < 2) || (content[bom + idx->positions[0]] != '[')) {
+        goto fail; /* not an array */
+    }
+
+    /* an empty array gets one stream that finds it empty */
+    if (content[bom + idx->positions[1]] == ']') {
+        if ((streams[0] = cJSON_StreamCreate(value, buffer_length)) == NULL) {
+            goto fail;
+        }
+        if (counts != NULL) {
+            counts[0] = 0;
+        }
+        jindexRelease(idx);
+        return 1;
+    }
+
+    start = bom + idx->positions[0] + 1;
+    target = buffer_length / parts;
+    elements = 1;
+
+    for (i = 0; i < idx->count; i++) {
+        c = content[bom + idx->positions[i]];
+
+        if ((c == '[') || (c == '{')) {
+            depth++;
+        } else if ((c == ']') || (c == '}')) {
+            if (--depth == 0) {
+                break; /* end of the top-level array */
+            }
+        } else if ((c == ',') && (depth == 1)) {
+            /* end the slice at the first element boundary past its share */
+            if ((bom + idx->positions[i] >= target) &&
+                (created < parts - 1)) {
+                if ((streams[created] = stream_create_slice(
+                         value, start, bom + idx->positions[i])) == NULL) {
+                    goto fail;
+                }
+                if (counts != NULL) {
+                    counts[created] = elements;
+                }
+                created++;
+                start = bom + idx->positions[i] + 1;
+                target = buffer_length / parts * (created + 1);
+                elements = 0;
+            }
+            elements++;
+        }
+    }
+
+    if (i == idx->count) {
+        goto fail; /* the array is never closed */
+    }
+
+    /* as with a single stream, only whitespace may follow the array */
+    for (end = bom + idx->positions[i] + 1; end < buffer_length; end++) {
+        if (content[end] > 32) {
+            goto fail;
+        }
+    }
+
+    if ((streams[created] = stream_create_slice(
+             value, start, bom + idx->positions[i])) == NULL) {
+        goto fail;
+    }
+    if (counts != NULL) {
+        counts[created] = elements;
+    }
+    created++;
+
+    jindexRelease(idx);
+    return created;
+
+fail:
+    while (created > 0) {
+        cJSON_StreamDelete(streams[--created]);
+    }
+    jindexRelease(idx);
+    return 0;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFailed(const cJSON_Stream *stream) {
+    return (stream == NULL) || (stream->state == STREAM_FAILED);
+}
+
+CJSON_PUBLIC(void) cJSON_StreamDelete(cJSON_Stream *stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    cJSON_ArenaDelete(stream->arena);
+    global_hooks.deallocate(stream);
+}
+
+/* Stage two of the indexed parser: build values by walking the structural
+ * index of the input rather than its bytes, see jindex.h */
+typedef struct {
+    parse_buffer buffer;
+    const size_t *positions;
+    size_t count;
+    size_t next; /* the next structural to consume */
+} index_walker;
+
+#define walker_peek(walker)                                                    \
+    (((walker)->next < (walker)->count)                                        \
+            ? (walker)->buffer.content[(walker)->positions[(walker)->next]]    \
+            : '\0')
+
+static cJSON_bool walk_value(cJSON *const item, index_walker *const walker);
+
+/* a scalar has to run right up to whitespace, a structural or the end */
+static cJSON_bool walk_scalar_end(const parse_buffer *const buffer) {
+    if (cannot_access_at_index(buffer, 0)) {
+        return true;
+    }
+
+    switch (buffer_at_offset(buffer)[0]) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+    case '\0':
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Link a new item onto the end of a child list */
+static cJSON *walk_new_child(
+    index_walker *const walker, cJSON **head, cJSON **current_item) {
+    cJSON *new_item = cJSON_New_Item(&walker->buffer.hooks);
+    if (new_item == NULL) {
+        return NULL;
+    }
+
+    if (*head == NULL) {
+        *current_item = *head = new_item;
+    } else {
+        (*current_item)->next = new_item;
+        new_item->prev = *current_item;
+        *current_item = new_item;
+    }
+
+    return new_item;
+}
+
+static cJSON_bool walk_array(cJSON *const item, index_walker *const walker) {
+    cJSON *head = NULL;
+    cJSON *current_item = NULL;
+    size_t count = 0;
+    unsigned char c = 0;
+
+    if (walker->buffer.depth >= CJSON_NESTING_LIMIT) {
+        return false; /* to deeply nested */
+    }
+    walker->buffer.depth++;
+
+    walker->next++; /* [ */
+    if (walker_peek(walker) == ']') {
+        walker->next++;
+        goto success; /* empty array */
+    }
+
+    for (;;) {
+        if (walk_new_child(walker, &head, &current_item) == NULL) {
+            goto fail; /* allocation failure */
+        }
+        count++;
+
+        if (!walk_value(current_item, walker)) {
+            goto fail;
+        }
+
+        c = walker_peek(walker);
+        walker->next++;
+        if (c == ']') {
+            break;
+        }
+        if (c != ',') {
+            goto fail; /* expected end of array */
+        }
+    }
+
+success:
+    walker->buffer.depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Array;
+    item->child = head;
+
+    if (count >= CJSON_INDEX_THRESHOLD) {
+        array_index_build(item, count, &walker->buffer.hooks);
+    }
+
+    return true;
+
+fail:
+    if (head != NULL) {
+        parse_delete(&walker->buffer, head);
+    }
+
+    return false;
+}
+
+static cJSON_bool walk_object(cJSON *const item, index_walker *const walker) {
+    cJSON *head = NULL;
+    cJSON *current_item = NULL;
+    size_t count = 0;
+    unsigned char c = 0;
+
+    if (walker->buffer.depth >= CJSON_NESTING_LIMIT) {
+        return false; /* to deeply nested */
+    }
+    walker->buffer.depth++;
+
+    walker->next++; /* { */
+    if (walker_peek(walker) == '}') {
+        walker->next++;
+        goto success; /* empty object */
+    }
+
+    for (;;) {
+        if (walk_new_child(walker, &head, &current_item) == NULL) {
+            goto fail; /* allocation failure */
+        }
+        count++;
+
+        /* parse the name of the child */
+        if (walker_peek(walker) != '\"') {
+            goto fail;
+        }
+        walker->buffer.offset = walker->positions[walker->next++];
+        if (!parse_key(current_item, &walker->buffer)) {
+            goto fail;
+        }
+
+        if (walker_peek(walker) != ':') {
+            goto fail; /* invalid object */
+        }
+        walker->next++;
+
+        if (!walk_value(current_item, walker)) {
+            goto fail;
+        }
+
+        c = walker_peek(walker);
+        walker->next++;
+        if (c == '}') {
+            break;
+        }
+        if (c != ',') {
+            goto fail; /* expected end of object */
+        }
+    }
+
+success:
+    walker->buffer.depth--;
+
+    if (head != NULL) {
+        head->prev = current_item;
+    }
+
+    item->type = cJSON_Object;
+    item->child = head;
+
+    if (count >= CJSON_INDEX_THRESHOLD) {
+        object_index_build(item, count, &walker->buffer.hooks);
+    }
+
+    return true;
+
+fail:
+    if (head != NULL) {
+        parse_delete(&walker->buffer, head);
+    }
+
+    return false;
+}
+
+static cJSON_bool walk_value(cJSON *const item, index_walker *const walker) {
+    parse_buffer *buffer = &walker->buffer;
+    cJSON_bool parsed = false;
+
+    if (walker->next >= walker->count) {
+        return false;
+    }
+
+    buffer->offset = walker->positions[walker->next];
+
+    switch (buffer_at_offset(buffer)[0]) {
+    case '[':
+        parsed = walk_array(item, walker);
+        break;
+    case '{':
+        parsed = walk_object(item, walker);
+        break;
+    default:
+        /* strings, numbers and literals are all a single structural */
+        walker->next++;
+        parsed = parse_value_type(item, buffer) && walk_scalar_end(buffer);
+        break;
+    }
+
+    if (parsed && (buffer->hooks.arena != NULL)) {
+        item->type |= cJSON_ArenaOwned;
+        /* the name is the arena's too, and may be shared */
+        if (item->string != NULL) {
+            item->type |= cJSON_StringIsConst;
+        }
+    }
+
+    return parsed;
+}
+
+CJSON_PUBLIC(cJSON *)
+cJSON_ParseIndexed(
+    const char *value, size_t buffer_length, cJSON_Arena *arena) {
+    index_walker walker;
+    jindex *idx = NULL;
+    cJSON *item = NULL;
+
+    global_error.json = NULL;
+    global_error.position = 0;
+
+    if ((value == NULL) || (buffer_length == 0)) {
+        return NULL;
+    }
+
+    memset(&walker, '\0', sizeof(walker));
+    walker.buffer.content = (const unsigned char *)value;
+    walker.buffer.length = buffer_length;
+    walker.buffer.hooks = global_hooks;
+    walker.buffer.hooks.arena = arena;
+
+    /* the index starts after the byte order mark */
+    skip_utf8_bom(&walker.buffer);
+    walker.buffer.content += walker.buffer.offset;
+    walker.buffer.length -= walker.buffer.offset;
+    walker.buffer.offset = 0;
+
+    /* stage one */
+    if ((idx = jindexBuild((const char *)walker.buffer.content,
+             walker.buffer.length)) == NULL) {
+        walker.buffer.offset = walker.buffer.length;
+        goto fail;
+    }
+    walker.positions = idx->positions;
+    walker.count = idx->count;
+
+    item = cJSON_New_Item(&walker.buffer.hooks);
+    if (item == NULL) {
+        goto fail;
+    }
+
+    /* stage two */
+    if (!walk_value(item, &walker)) {
+        if (walker.next < walker.count) {
+            walker.buffer.offset = walker.positions[walker.next];
+        }
+        goto fail;
+    }
+
+    /* nothing but whitespace may follow the value */
+    if (walker.next < walker.count) {
+        walker.buffer.offset = walker.positions[walker.next];
+        goto fail;
+    }
+
+    jindexRelease(idx);
+    return item;
+
+fail:
+    if (item != NULL) {
+        parse_delete(&walker.buffer, item);
+    }
+    jindexRelease(idx);
+
+    global_error.json = walker.buffer.content;
+    global_error.position = walker.buffer.offset < walker.buffer.length
+                                ? walker.buffer.offset
+                                : walker.buffer.length - 1;
+
+    return NULL;
+}
+
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
 
 static unsigned char *print(const cJSON *const item, cJSON_bool format,
@@ -1149,7 +2247,7 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item) {
 
 CJSON_PUBLIC(char *)
 cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt) {
-    printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}};
+    printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0, 0}};
 
     if (prebuffer < 0) {
         return NULL;
@@ -1177,7 +2275,7 @@ cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt) {
 CJSON_PUBLIC(cJSON_bool)
 cJSON_PrintPreallocated(
     cJSON *item, char *buffer, const int length, const cJSON_bool format) {
-    printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0}};
+    printbuffer p = {0, 0, 0, 0, 0, 0, {0, 0, 0, 0}};
 
     if ((length < 0) || (buffer == NULL)) {
         return false;
@@ -1194,7 +2292,7 @@ cJSON_PrintPreallocated(
 }
 
 /* Parser core - when encountering text, process appropriately. */
-static cJSON_bool parse_value(
+static cJSON_bool parse_value_type(
     cJSON *const item, parse_buffer *const input_buffer) {
     if ((input_buffer == NULL) || (input_buffer->content == NULL)) {
         return false; /* no input */
@@ -1252,6 +2350,24 @@ static cJSON_bool parse_value(
     return false;
 }
 
+static cJSON_bool parse_value(
+    cJSON *const item, parse_buffer *const input_buffer) {
+    if (!parse_value_type(item, input_buffer)) {
+        return false;
+    }
+
+    /* mark the item so cJSON_Delete leaves it to the arena */
+    if (input_buffer->hooks.arena != NULL) {
+        item->type |= cJSON_ArenaOwned;
+        /* the name is the arena's too, and may be shared */
+        if (item->string != NULL) {
+            item->type |= cJSON_StringIsConst;
+        }
+    }
+
+    return true;
+}
+
 /* Render a value to text. */
 static cJSON_bool print_value(
     const cJSON *const item, printbuffer *const output_buffer) {
@@ -1323,6 +2439,7 @@ static cJSON_bool parse_array(
     cJSON *const item, parse_buffer *const input_buffer) {
     cJSON *head = NULL; /* head of the linked list */
     cJSON *current_item = NULL;
+    size_t count = 0;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT) {
         return false; /* to deeply nested */
@@ -1368,6 +2485,7 @@ static cJSON_bool parse_array(
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         /* parse next value */
         input_buffer->offset++;
@@ -1394,13 +2512,17 @@ success:
     item->type = cJSON_Array;
     item->child = head;
 
+    if (count >= CJSON_INDEX_THRESHOLD) {
+        array_index_build(item, count, &input_buffer->hooks);
+    }
+
     input_buffer->offset++;
 
     return true;
 
 fail:
     if (head != NULL) {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
@@ -1465,6 +2587,7 @@ static cJSON_bool parse_object(
     cJSON *const item, parse_buffer *const input_buffer) {
     cJSON *head = NULL; /* linked list head */
     cJSON *current_item = NULL;
+    size_t count = 0;
 
     if (input_buffer->depth >= CJSON_NESTING_LIMIT) {
         return false; /* to deeply nested */
@@ -1509,19 +2632,16 @@ static cJSON_bool parse_object(
             new_item->prev = current_item;
             current_item = new_item;
         }
+        count++;
 
         /* parse the name of the child */
         input_buffer->offset++;
         buffer_skip_whitespace(input_buffer);
-        if (!parse_string(current_item, input_buffer)) {
+        if (!parse_key(current_item, input_buffer)) {
             goto fail; /* failed to parse name */
         }
         buffer_skip_whitespace(input_buffer);
 
-        /* swap valuestring and string, because we parsed the name */
-        current_item->string = current_item->valuestring;
-        current_item->valuestring = NULL;
-
         if (cannot_access_at_index(input_buffer, 0) ||
             (buffer_at_offset(input_buffer)[0] != ':')) {
             goto fail; /* invalid object */
@@ -1552,12 +2672,16 @@ success:
     item->type = cJSON_Object;
     item->child = head;
 
+    if (count >= CJSON_INDEX_THRESHOLD) {
+        object_index_build(item, count, &input_buffer->hooks);
+    }
+
     input_buffer->offset++;
     return true;
 
 fail:
     if (head != NULL) {
-        cJSON_Delete(head);
+        parse_delete(input_buffer, head);
     }
 
     return false;
@@ -1672,6 +2796,10 @@ CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array) {
         return 0;
     }
 
+    if (array->index != NULL) {
+        return (int)array->index->count;
+    }
+
     child = array->child;
 
     while (child != NULL) {
@@ -1691,6 +2819,10 @@ static cJSON *get_array_item(const cJSON *array, size_t index) {
         return NULL;
     }
 
+    if (has_array_index(array)) {
+        return index < array->index->count ? array->index->slots[index] : NULL;
+    }
+
     current_child = array->child;
     while ((current_child != NULL) && (index > 0)) {
         index--;
@@ -1716,9 +2848,14 @@ static cJSON *get_object_item(const cJSON *const object, const char *const name,
         return NULL;
     }
 
+    if (case_sensitive && has_object_index(object)) {
+        return object_index_find(object->index, name);
+    }
+
     current_element = object->child;
     if (case_sensitive) {
         while ((current_element != NULL) && (current_element->string != NULL) &&
+               (current_element->string != name) &&
                (strcmp(name, current_element->string) != 0)) {
             current_element = current_element->next;
         }
@@ -1773,6 +2910,7 @@ static cJSON *create_reference(
     }
 
     memcpy(reference, item, sizeof(cJSON));
+    reference->index = NULL;
     reference->string = NULL;
     reference->type |= cJSON_IsReference;
     reference->next = reference->prev = NULL;
@@ -1786,6 +2924,7 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item) {
         return false;
     }
 
+    index_drop(array);
     child = array->child;
     /*
      * To find the last item in array quickly, we use prev in array
@@ -2001,6 +3140,7 @@ cJSON_DetachItemViaPointer(cJSON *parent, cJSON *const item) {
         return NULL;
     }
 
+    index_drop(parent);
     if (item != parent->child) {
         /* not the first element */
         item->prev->next = item->next;
@@ -2076,6 +3216,7 @@ cJSON_InsertItemInArray(cJSON *array, int which, cJSON *newitem) {
         return add_item_to_array(array, newitem);
     }
 
+    index_drop(array);
     newitem->next = after_inserted;
     newitem->prev = after_inserted->prev;
     after_inserted->prev = newitem;
@@ -2098,6 +3239,7 @@ cJSON_ReplaceItemViaPointer(
         return true;
     }
 
+    index_drop(parent);
     replacement->next = item->next;
     replacement->prev = item->prev;
 
@@ -2455,7 +3597,11 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse) {
         goto fail;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_ArenaOwned));
+    /* an arena's names go away with it, the copy needs its own */
+    if (item->type & cJSON_ArenaOwned) {
+        newitem->type &= ~cJSON_StringIsConst;
+    }
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
     if (item->valuestring) {
@@ -2467,7 +3613,7 @@ CJSON_PUBLIC(cJSON *) cJSON_Duplicate(const cJSON *item, cJSON_bool recurse) {
     }
     if (item->string) {
         newitem->string =
-            (item->type & cJSON_StringIsConst)
+            (newitem->type & cJSON_StringIsConst)
                 ? item->string
                 : (char *)cJSON_strdup(
                       (unsigned char *)item->string, &global_hooks);
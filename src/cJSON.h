@@ -106,6 +106,8 @@ CJSON_EXPORT_SYMBOLS does
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+/* The item was parsed into a cJSON_Arena, cJSON_Delete leaves it alone */
+#define cJSON_ArenaOwned 1024
 
 /* The cJSON structure: */
 typedef struct cJSON {
@@ -130,6 +132,11 @@ typedef struct cJSON {
     /* The item's name string, if this item is the child of, or is in the list
      * of subitems of an object. */
     char *string;
+
+    /* Index of the items of a long array or the members of a wide object,
+     * built by the parser and dropped whenever they change. Internal to
+     * cJSON. */
+    struct cJSON_Index *index;
 } cJSON;
 
 typedef struct cJSON_Hooks {
@@ -142,12 +149,34 @@ typedef struct cJSON_Hooks {
 
 typedef int cJSON_bool;
 
+/* A bump allocator that items can be parsed into, see cJSON_ParseWithArena */
+typedef struct cJSON_Arena cJSON_Arena;
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse
  * them. This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* Parsed objects with at least this many members get a hash index, so that
+ * cJSON_GetObjectItemCaseSensitive does not have to search them linearly,
+ * and arrays with at least this many items get a vector of them, so that
+ * cJSON_GetArrayItem and cJSON_GetArraySize do not walk the list */
+#ifndef CJSON_INDEX_THRESHOLD
+#define CJSON_INDEX_THRESHOLD 16
+#endif
+
+/* Most distinct object member names a cJSON_Arena keeps a shared copy of,
+ * names past the limit are copied for every member as usual */
+#ifndef CJSON_INTERN_LIMIT
+#define CJSON_INTERN_LIMIT 4096
+#endif
+
+/* Default size of the blocks a cJSON_Arena allocates from */
+#ifndef CJSON_ARENA_BLOCK_SIZE
+#define CJSON_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
 /* returns the version of cJSON as a string */
 CJSON_PUBLIC(const char *) cJSON_Version(void);
 
@@ -176,6 +205,67 @@ CJSON_PUBLIC(cJSON *)
 cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length,
     const char **return_parse_end, cJSON_bool require_null_terminated);
 
+/* Arena parsing: every item and string of the document is bump allocated from
+ * the arena, next to each other in memory. The document is released in one
+ * go by cJSON_ArenaReset, which keeps the blocks around for the next parse, or
+ * cJSON_ArenaDelete. cJSON_Delete is a no-op on arena owned items. A block
+ * size of 0 selects CJSON_ARENA_BLOCK_SIZE.
+ * Object member names are interned: members with the same name share one
+ * string, flagged cJSON_StringIsConst, that is kept across cJSON_ArenaReset
+ * so the records of an array all point at the same names. */
+CJSON_PUBLIC(cJSON_Arena *) cJSON_ArenaCreate(size_t block_size);
+CJSON_PUBLIC(void) cJSON_ArenaReset(cJSON_Arena *arena);
+CJSON_PUBLIC(void) cJSON_ArenaDelete(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *)
+cJSON_ParseWithArena(
+    const char *value, size_t buffer_length, cJSON_Arena *arena);
+
+/* Two stage parse: a SIMD pass first indexes the structural characters of the
+ * input, values are then built by walking that index instead of scanning byte
+ * at a time. Unlike cJSON_ParseWithLength, anything but whitespace after the
+ * value is an error. The arena is optional, pass NULL to use the hooks. */
+CJSON_PUBLIC(cJSON *)
+cJSON_ParseIndexed(
+    const char *value, size_t buffer_length, cJSON_Arena *arena);
+
+/* Pull parser over the elements of a top-level array. Rather than building
+ * the whole document, each call to cJSON_StreamNext parses and returns the
+ * next element only. The returned item is owned by the stream and is released
+ * by the following call to cJSON_StreamNext or cJSON_StreamDelete, so peak
+ * memory is bounded by the largest element rather than the whole document.
+ * Elements are parsed into an arena owned by the stream which is rewound on
+ * each call, reusing the previous element's memory. */
+typedef struct cJSON_Stream cJSON_Stream;
+
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreate(const char *value, size_t buffer_length);
+/* Returns NULL once the closing bracket has been consumed or when the input
+ * could not be parsed, use cJSON_StreamFailed to tell the two apart. As with
+ * cJSON_ParseIndexed, anything but whitespace after the closing bracket is
+ * an error. */
+CJSON_PUBLIC(cJSON *) cJSON_StreamNext(cJSON_Stream *stream);
+CJSON_PUBLIC(cJSON_bool) cJSON_StreamFailed(const cJSON_Stream *stream);
+CJSON_PUBLIC(void) cJSON_StreamDelete(cJSON_Stream *stream);
+/* A stream over newline delimited JSON (NDJSON), each call to
+ * cJSON_StreamNext returns the value on the next non blank line. A value
+ * must be on a single line, anything else on its line is an error. */
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreateLines(const char *value, size_t buffer_length);
+/* A stream over a run of array elements separated by commas, without the
+ * brackets around them or a comma either end, e.g. `1, {"a": 2}, [3]`. */
+CJSON_PUBLIC(cJSON_Stream *)
+cJSON_StreamCreateSlice(const char *value, size_t buffer_length);
+/* Splits a top-level array into at most `parts` streams over consecutive
+ * runs of its elements, of about the same size in bytes, so they can be
+ * parsed on separate threads. Element boundaries are found with stage one of
+ * the indexed parser. Returns how many streams were stored in `streams`,
+ * with the number of elements in each in `counts` if it is not NULL, or 0 if
+ * the input is not an array or it is never closed. Errors within elements
+ * are only found by cJSON_StreamNext. */
+CJSON_PUBLIC(size_t)
+cJSON_StreamSplit(const char *value, size_t buffer_length, size_t parts,
+    cJSON_Stream **streams, size_t *counts);
+
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
 /* Render a cJSON entity to text for transfer/storage without any formatting. */
@@ -210,7 +300,8 @@ CJSON_PUBLIC(cJSON_bool)
 cJSON_HasObjectItem(const cJSON *object, const char *string);
 /* For analysing failed parses. This returns a pointer to the parse error.
  * You'll probably need to look a few chars back to make sense of it. Defined
- * when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
+ * when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. Each thread
+ * has its own error where thread local storage is supported. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
 /* Check item type and return its value */
@@ -0,0 +1,228 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "cache.h"
+#include "sink.h"
+
+#define CACHE_MAGIC "JCC1"
+/* Caches are native endian, one written on another machine is a miss */
+#define CACHE_BYTE_ORDER 0x01020304
+
+/**
+ * On disk the header is followed by the path, x name and y name without
+ * terminators, padded to a multiple of 8 bytes so the x column and then the
+ * y column that follow are aligned.
+ */
+typedef struct cacheHeader {
+    char magic[4];
+    uint32_t byteOrder;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeSec;
+    int64_t mtimeNsec;
+    uint32_t pathLen;
+    uint32_t xNameLen;
+    uint32_t yNameLen;
+    int32_t xType;
+    int32_t yType;
+    int32_t format;
+    uint64_t len;
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+} cacheHeader;
+
+static size_t cacheNamesLen(cacheHeader *header) {
+    size_t len;
+
+    len = (size_t)header->pathLen + header->xNameLen + header->yNameLen;
+    return (len + 7) & ~(size_t)7;
+}
+
+static void cacheHeaderInit(cacheHeader *header, cacheKey *key) {
+    memset(header, 0, sizeof(cacheHeader));
+    memcpy(header->magic, CACHE_MAGIC, 4);
+    header->byteOrder = CACHE_BYTE_ORDER;
+    header->dev = key->sb->st_dev;
+    header->ino = key->sb->st_ino;
+    header->size = key->sb->st_size;
+    header->mtimeSec = key->sb->st_mtim.tv_sec;
+    header->mtimeNsec = key->sb->st_mtim.tv_nsec;
+    header->pathLen = strlen(key->path);
+    header->xNameLen = strlen(key->xName);
+    header->yNameLen = strlen(key->yName);
+    header->xType = key->xType;
+    header->yType = key->yType;
+    header->format = key->format;
+}
+
+static int cacheMatches(cacheHeader *header, char *names, size_t mapLen,
+        cacheKey *key)
+{
+    cacheHeader want;
+    size_t columnsLen;
+
+    cacheHeaderInit(&want, key);
+
+    /* Everything up to the number of points has to be the same */
+    if (memcmp(header, &want, offsetof(cacheHeader, len)) != 0)
+        return 0;
+
+    if (mapLen < sizeof(cacheHeader) + cacheNamesLen(header))
+        return 0;
+
+    if (memcmp(names, key->path, want.pathLen) != 0 ||
+            memcmp(names + want.pathLen, key->xName, want.xNameLen) != 0 ||
+            memcmp(names + want.pathLen + want.xNameLen, key->yName,
+                want.yNameLen) != 0)
+        return 0;
+
+    columnsLen = mapLen - sizeof(cacheHeader) - cacheNamesLen(header);
+    return header->len <= SIZE_MAX / (sizeof(double) * 2) &&
+            columnsLen == header->len * sizeof(double) * 2;
+}
+
+int cacheLoad(char *cachepath, cacheKey *key, cacheColumns *cols) {
+    cacheHeader *header;
+    struct stat sb;
+    char *map;
+    int fd;
+
+    if ((fd = open(cachepath, O_RDONLY)) == -1)
+        return errno == ENOENT ? CACHE_MISS : CACHE_ERR;
+
+    if (fstat(fd, &sb) == -1) {
+        close(fd);
+        return CACHE_ERR;
+    }
+
+    if ((size_t)sb.st_size < sizeof(cacheHeader)) {
+        close(fd);
+        return CACHE_MISS;
+    }
+
+    map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return CACHE_ERR;
+
+    header = (cacheHeader *)map;
+    if (!cacheMatches(header, map + sizeof(cacheHeader), sb.st_size, key)) {
+        munmap(map, sb.st_size);
+        return CACHE_MISS;
+    }
+
+    cols->xValues = (double *)(map + sizeof(cacheHeader) +
+            cacheNamesLen(header));
+    cols->yValues = cols->xValues + header->len;
+    cols->len = header->len;
+    cols->xMin = header->xMin;
+    cols->xMax = header->xMax;
+    cols->yMin = header->yMin;
+    cols->yMax = header->yMax;
+    cols->map = map;
+    cols->mapLen = sb.st_size;
+    return CACHE_OK;
+}
+
+int cacheStore(char *cachepath, cacheKey *key, cacheColumns *cols) {
+    static const char padding[8];
+    struct iovec iov[7];
+    cacheHeader header;
+    char *tmppath;
+    size_t tmplen;
+    int fd, saved, status;
+
+    cacheHeaderInit(&header, key);
+    header.len = cols->len;
+    header.xMin = cols->xMin;
+    header.xMax = cols->xMax;
+    header.yMin = cols->yMin;
+    header.yMax = cols->yMax;
+
+    iov[0].iov_base = &header;
+    iov[0].iov_len = sizeof(cacheHeader);
+    iov[1].iov_base = key->path;
+    iov[1].iov_len = header.pathLen;
+    iov[2].iov_base = key->xName;
+    iov[2].iov_len = header.xNameLen;
+    iov[3].iov_base = key->yName;
+    iov[3].iov_len = header.yNameLen;
+    iov[4].iov_base = (char *)padding;
+    iov[4].iov_len = cacheNamesLen(&header) - header.pathLen -
+            header.xNameLen - header.yNameLen;
+    iov[5].iov_base = cols->xValues;
+    iov[5].iov_len = cols->len * sizeof(double);
+    iov[6].iov_base = cols->yValues;
+    iov[6].iov_len = cols->len * sizeof(double);
+
+    /* Readers only ever see a whole cache */
+    tmplen = strlen(cachepath) + 32;
+    if ((tmppath = malloc(tmplen)) == NULL)
+        return CACHE_ERR;
+    snprintf(tmppath, tmplen, "%s.%ld.tmp", cachepath, (long)getpid());
+
+    if ((fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1) {
+        free(tmppath);
+        return CACHE_ERR;
+    }
+
+    status = sinkWritev(fd, iov, 7) == SINK_OK ? CACHE_OK : CACHE_ERR;
+    if (close(fd) == -1)
+        status = CACHE_ERR;
+    if (status == CACHE_OK && rename(tmppath, cachepath) == -1)
+        status = CACHE_ERR;
+
+    if (status == CACHE_ERR) {
+        saved = errno;
+        unlink(tmppath);
+        errno = saved;
+    }
+
+    free(tmppath);
+    return status;
+}
+
+void cacheRelease(cacheColumns *cols) {
+    if (cols->map)
+        munmap(cols->map, cols->mapLen);
+    cols->map = NULL;
+}
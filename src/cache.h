@@ -0,0 +1,81 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+#define CACHE_OK    1
+#define CACHE_MISS  0
+#define CACHE_ERR  -1
+
+/* Added to the path of the input to name its cache */
+#define CACHE_SUFFIX ".jcc"
+
+/**
+ * What a cache was extracted from, it is only used if all of this matches.
+ * The device, inode, size and modification time of the input come from `sb`
+ * so a cache goes stale as soon as the input changes.
+ */
+typedef struct cacheKey {
+    char *path;
+    struct stat *sb;
+    char *xName;
+    char *yName;
+    int xType;
+    int yType;
+    int format;
+} cacheKey;
+
+/**
+ * The extracted x and y columns with their minimum and maximum, in the order
+ * of the input. Loaded columns are mapped read only from the cache.
+ */
+typedef struct cacheColumns {
+    double *xValues;
+    double *yValues;
+    size_t len;
+    double xMin;
+    double xMax;
+    double yMin;
+    double yMax;
+    void *map;
+    size_t mapLen;
+} cacheColumns;
+
+/* CACHE_MISS if there is no cache or it does not match the key */
+int cacheLoad(char *cachepath, cacheKey *key, cacheColumns *cols);
+/* Written to a temporary file and renamed in to place, errno is set on
+ * CACHE_ERR */
+int cacheStore(char *cachepath, cacheKey *key, cacheColumns *cols);
+void cacheRelease(cacheColumns *cols);
+
+#endif
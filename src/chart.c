@@ -39,6 +39,7 @@
  */
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,6 +48,10 @@
 #include <float.h>
 
 #include "chart.h"
+#include "cstr.h"
+#include "reduce.h"
+#include "sink.h"
+#include "transform.h"
 
 
 #define X_AXIS 0
@@ -55,15 +60,31 @@
 #define AXIS_COLOR "#CCCCCC"
 #define TICK_COLOR "#333333"
 
+/* Each series of a multi line chart takes the next colour */
+static const char *chartSeriesColors[] = {
+    LINE_COLOR, "#FF6B00", "#00A86B", "#D6246E", "#7A4DFF",
+    "#F2B705", "#00B3C7", "#8C564B", "#7F7F7F", "#BCBD22"
+};
+
+#define chartSeriesColor(i)                                                    \
+    (chartSeriesColors[(i) % (sizeof(chartSeriesColors) /                      \
+                              sizeof(chartSeriesColors[0]))])
+
+/* Points each thread formats at a time */
+#define CHART_THREAD_POINTS (1 << 16)
+
+/* Points transformed at a time when formatting straight from the columns,
+ * small enough to stay in the cache */
+#define CHART_SCREEN_BLOCK 1024
+
 #define abs(x) ((x) >= 0 ? (x) : -1 * (x))
 
+/* Any real value replaces both ends, DBL_MIN is the smallest positive double
+ * and would stay the max of negative data */
 #define chartInitScale(cs)                                                     \
-    ((cs)->valMax = DBL_MIN, (cs)->valMin = DBL_MAX, (cs)->rangeMin = 0,       \
+    ((cs)->valMax = -DBL_MAX, (cs)->valMin = DBL_MAX, (cs)->rangeMin = 0,      \
             (cs)->rangeMax = 0)
 
-#define linearScale(cs, value)                                                 \
-    (((value) - (cs->valMin)) * ((cs)->rangeMax - (cs)->rangeMin) /            \
-        ((cs)->valMax - (cs)->valMin) + (cs)->rangeMin)
 
 typedef struct chartPointArray {
     int len;
@@ -87,6 +108,31 @@ typedef struct chartScale {
     double rangeMax;
 } chartScale;
 
+/* Screen space is reached with a multiply and an add per value */
+typedef struct chartTransform {
+    double xScale;
+    double xOffset;
+    double yScale;
+    double yOffset;
+} chartTransform;
+
+/* A line in screen space, float is plenty for pixel co-ordinates and halves
+ * what a line takes to hold */
+typedef struct chartScreenPoints {
+    int len;
+    float *x;
+    float *y;
+} chartScreenPoints;
+
+static chartOptions chartDefaultOptions = {
+    CHART_DOWNSAMPLE_NONE, 0, CHART_DEFAULT_PRECISION, 1, CHART_PATH_ABSOLUTE,
+    CHART_DEFAULT_PATH_GRID, 0
+};
+
+void chartOptionsInit(chartOptions *options) {
+    *options = chartDefaultOptions;
+}
+
 static void _xAxisDefaultFormatter(double val, char *buf) {
     int len;
 
@@ -109,116 +155,543 @@ static void _yAxisDefaultFormatter(double val, char *buf) {
  * {100, 250, 400, 550, 700, 850, 1000}
  */
 static void _getRange(double min, double max, double *out, int outlen) {
-    double difference, _outlen, step, iters, i;
-    unsigned int j;
+    double step;
+    int j;
 
-    _outlen = outlen - 1;
+    step = (max - min) / (outlen - 1);
+    for (j = 0; j < outlen - 1; ++j)
+        out[j] = min + step * j;
 
-    difference = abs(max - min);
-    step = difference / _outlen;
-    iters = step * (outlen - 1);
+    out[outlen - 1] = max;
+}
 
-    j = 0;
-    for (i = 0; i < iters; i += step)
-        out[j++] = (min + i);
+/* Widen the scales to cover the columns, NaNs are skipped */
+static void chartScaleColumns(chartPointArray *cp_array, chartScale *csx,
+        chartScale *csy)
+{
+    reduceMinMax(cp_array->xValues, cp_array->len, &csx->valMin,
+            &csx->valMax);
+    reduceMinMax(cp_array->yValues, cp_array->len, &csy->valMin,
+            &csy->valMax);
+}
 
-    out[outlen - 1] = max;
+/*================ Screen space =================*/
+/* Where the plot is on the chart, reversed charts run x from right to left */
+static void chartScaleRanges(chartDimensions *cDim, chartOptions *options,
+        chartScale *csx, chartScale *csy)
+{
+    csx->rangeMin = cDim->marginLeft - cDim->marginRight;
+    csx->rangeMax = csx->rangeMin + cDim->width;
+    if (options->reverse) {
+        csx->rangeMax = csx->rangeMin;
+        csx->rangeMin = csx->rangeMax + cDim->width;
+    }
+    csy->rangeMin = 0;
+    csy->rangeMax = cDim->height - cDim->marginTop;
 }
 
-static void chartCalculateScales(chartDimensions *dimensions,
-        chartPointArray *cp_array, chartScale **scales)
+/**
+ * The scales map values on to their range, x across the plot from the left
+ * margin and y up from the bottom of the plot as SVG y grows downwards. A
+ * column holding a single value has nothing to spread over the range and is
+ * drawn at the start of it.
+ */
+static void chartTransformInit(chartTransform *tf, chartDimensions *cDim,
+        chartScale *csx, chartScale *csy)
 {
-    chartScale *csy, *csx;
-    int i;
-    csy = scales[Y_AXIS];
-    csx = scales[X_AXIS];
+    double span;
+
+    span = csx->valMax - csx->valMin;
+    tf->xScale = span > 0 ? (csx->rangeMax - csx->rangeMin) / span : 0;
+    tf->xOffset = csx->rangeMin - csx->valMin * tf->xScale;
+
+    span = csy->valMax - csy->valMin;
+    tf->yScale = span > 0 ? -(csy->rangeMax - csy->rangeMin) / span : 0;
+    tf->yOffset = cDim->height - csy->rangeMin - csy->valMin * tf->yScale;
+}
+
+/* Points `start` to `start + len` of a line in to screen space */
+static void chartTransformPoints(chartPointArray *cpArr, chartTransform *tf,
+        int start, int len, float *x, float *y)
+{
+    transformAffine(cpArr->xValues + start, len, tf->xScale, tf->xOffset, x);
+    transformAffine(cpArr->yValues + start, len, tf->yScale, tf->yOffset, y);
+}
+
+/*================ Downsampling =================*/
+/**
+ * Points are chosen by where they land on the chart, so the line is
+ * transformed in to screen space first. Each function fills `keep` with the
+ * indexes of the points to plot in ascending order and returns how many
+ * there are.
+ */
 
-    for (i = 0; i < cp_array->len; ++i) {
-        double x = cp_array->xValues[i];
-        double y = cp_array->yValues[i];
+/**
+ * Largest-Triangle-Three-Buckets: the first and last points are always kept,
+ * the rest are split into `target - 2` buckets and from each bucket we keep
+ * the point making the largest triangle with the previously kept point and
+ * the average of the next bucket.
+ */
+static int chartDownsampleLttb(chartScreenPoints *pts, int target,
+        int *keep)
+{
+    double every, area, maxArea, avgX, avgY, ax, ay;
+    float *x, *y;
+    int i, j, a, next, rangeStart, rangeEnd, avgStart, avgEnd, count;
+
+    x = pts->x;
+    y = pts->y;
+    every = (double)(pts->len - 2) / (target - 2);
+    count = 0;
+    a = 0;
+    keep[count++] = a;
+
+    for (i = 0; i < target - 2; ++i) {
+        avgStart = (int)((i + 1) * every) + 1;
+        avgEnd = (int)((i + 2) * every) + 1;
+        if (avgEnd > pts->len)
+            avgEnd = pts->len;
+
+        avgX = avgY = 0;
+        for (j = avgStart; j < avgEnd; ++j) {
+            avgX += x[j];
+            avgY += y[j];
+        }
+        avgX /= avgEnd - avgStart;
+        avgY /= avgEnd - avgStart;
+
+        rangeStart = (int)(i * every) + 1;
+        rangeEnd = (int)((i + 1) * every) + 1;
+
+        ax = x[a];
+        ay = y[a];
+        maxArea = -1;
+        next = rangeStart;
+
+        for (j = rangeStart; j < rangeEnd; ++j) {
+            area = abs((ax - avgX) * (y[j] - ay) - (ax - x[j]) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                next = j;
+            }
+        }
+
+        keep[count++] = a = next;
+    }
+
+    keep[count++] = pts->len - 1;
+    return count;
+}
+
+/**
+ * M4: for every pixel column the line passes through keep the first, min,
+ * max and last point. Drawing these gives the same rasterised line as
+ * drawing every point. Each run of consecutive points in one column is
+ * reduced on its own, when x is sorted that is the whole column. A run
+ * never keeps more points than it has, so `keep` needs room for at most
+ * every point.
+ */
+static int chartDownsampleM4(chartScreenPoints *pts, int *keep) {
+    float *x, *y;
+    int i, first, min, max, column, nextColumn, count;
+
+    x = pts->x;
+    y = pts->y;
+    count = 0;
+
+    /* x is never negative so truncating is the same as flooring */
+    column = nextColumn = (int)x[0];
+    first = min = max = 0;
+
+    for (i = 1; i <= pts->len; ++i) {
+        if (i < pts->len) {
+            nextColumn = (int)x[i];
+
+            if (nextColumn == column) {
+                if (y[i] < y[min]) min = i;
+                if (y[i] > y[max]) max = i;
+                continue;
+            }
+        }
 
-        if (x > csx->valMax)
-            csx->valMax = x;
-        if (x < csx->valMin)
-            csx->valMin = x;
+        /* The column is finished, keep its points in index order */
+        keep[count++] = first;
+        if (min < max) {
+            if (min != first) keep[count++] = min;
+            if (max != i - 1) keep[count++] = max;
+        } else {
+            if (max != first) keep[count++] = max;
+            if (min != i - 1 && min != max) keep[count++] = min;
+        }
+        if (i - 1 != first) keep[count++] = i - 1;
 
-        if (y > csy->valMax)
-            csy->valMax = y;
-        if (y < csy->valMin)
-            csy->valMin = y;
+        first = min = max = i;
+        column = nextColumn;
     }
 
-    csy->rangeMin = 0;
-    csy->rangeMax = dimensions->height - dimensions->marginTop;
+    return count;
+}
+
+/**
+ * When the line is downsampled `screen` is filled with the points to plot
+ * and how many there are is returned. Otherwise `screen` is left empty and
+ * every point is plotted straight from the columns. -1 on allocation
+ * failure.
+ */
+static int chartDownsample(chartPointArray *cpArr, chartTransform *tf,
+        chartDimensions *cDim, chartOptions *options,
+        chartScreenPoints *screen)
+{
+    int i, target, count, *keep;
+
+    memset(screen, 0, sizeof(chartScreenPoints));
+    target = 0;
+
+    if (options->downsample == CHART_DOWNSAMPLE_NONE)
+        return cpArr->len;
+
+    if (options->downsample == CHART_DOWNSAMPLE_M4) {
+        /* Sorted points land in at most `width + 1` columns */
+        if (cpArr->len <= 4 * (cDim->width + 1))
+            return cpArr->len;
+    } else {
+        if ((target = options->downsampleTarget) <= 0)
+            target = cDim->width;
+
+        /* LTTB needs the two end points and at least one bucket */
+        if (target < 3)
+            target = 3;
+
+        if (cpArr->len <= target)
+            return cpArr->len;
+    }
+
+    keep = malloc(sizeof(int) * (target ? target : cpArr->len));
+    screen->x = malloc(sizeof(float) * cpArr->len);
+    screen->y = malloc(sizeof(float) * cpArr->len);
+    if (keep == NULL || screen->x == NULL || screen->y == NULL) {
+        free(keep);
+        free(screen->x);
+        free(screen->y);
+        screen->x = screen->y = NULL;
+        return -1;
+    }
+
+    chartTransformPoints(cpArr, tf, 0, cpArr->len, screen->x, screen->y);
+    screen->len = cpArr->len;
+
+    if (options->downsample == CHART_DOWNSAMPLE_M4)
+        count = chartDownsampleM4(screen, keep);
+    else
+        count = chartDownsampleLttb(screen, target, keep);
 
-    csx->rangeMin = 0;
-    csx->rangeMax = dimensions->width - dimensions->marginLeft;
+    /* The indexes ascend, so the kept points can be moved down in place */
+    for (i = 0; i < count; ++i) {
+        screen->x[i] = screen->x[keep[i]];
+        screen->y[i] = screen->y[keep[i]];
+    }
+    screen->len = count;
+
+    free(keep);
+    return count;
 }
 
 /*================ Axis plotting functions =================*/
 /**
- * `int *outlen` needs to be zero'd out before pumping into these functions
- * and is assumed to be keeping track of the larger buffer for the whole
- * chart.
+ * These all write to `out`, the sink for the whole chart, returning SINK_ERR
+ * with errno set if it fails.
  */
 
+/* Absolute `L` commands at `precision` decimal places, `index` is where the
+ * first point is in the line */
+static int chartFormatAbsolute(sink *out, float *xs, float *ys, int n,
+        int index, int precision)
+{
+    int i, len;
+    char *dst;
+
+    for (i = 0; i < n; ++i) {
+        /* A command, two co-ordinates and a comma */
+        if ((dst = sinkReserve(out, CSTR_FIXED_BUFSIZ * 2 + 2)) == NULL)
+            return SINK_ERR;
+
+        len = 0;
+        dst[len++] = index + i ? 'L' : 'M';
+        len += cstrFormatFixed(dst + len, xs[i], precision);
+        dst[len++] = ',';
+        len += cstrFormatFixed(dst + len, ys[i], precision);
+        sinkCommit(out, len);
+    }
+
+    return SINK_OK;
+}
+
+/* A screen co-ordinate in whole steps of 1 / grid px, NaN and anything far
+ * off of the chart are left as they are */
+static double chartQuantise(float value, int grid) {
+    double scaled;
+
+    scaled = (double)value * grid;
+    if (!(scaled > -1e15 && scaled < 1e15))
+        return scaled;
+    return (double)(long long)(scaled + (scaled < 0 ? -0.5 : 0.5));
+}
+
 /**
- * This returns a buffer that will be the co-ordinates of where to plot a line
- * on an SVG chart.
+ * Relative `l` commands in whole steps of 1 / grid px, the path is scaled
+ * back down when it is drawn. The first point is a moveto and the second
+ * always starts the lineto, after that a point on the same step as the one
+ * before it is dropped. `*prevX` and `*prevY` carry the last point between
+ * calls. Numbers only need a separator when they do not start with a '-'.
  */
-static char *_chartLinePointsToString(chartPointArray *cpArr,
-        chartDimensions *cDim, chartScale *csy, int *len)
+static int chartFormatRelative(sink *out, float *xs, float *ys, int n,
+        int index, int grid, double *prevX, double *prevY)
 {
-    int i, offset;
-    char *outstr;
-    double xSpace, acc, x, y;
+    double x, y, dx, dy;
+    int i, len;
+    char *dst;
+
+    for (i = 0; i < n; ++i, ++index) {
+        x = chartQuantise(xs[i], grid);
+        y = chartQuantise(ys[i], grid);
+        dx = x - *prevX;
+        dy = y - *prevY;
+        *prevX = x;
+        *prevY = y;
+
+        if (index > 1 && dx == 0 && dy == 0)
+            continue;
+
+        /* A command, two numbers and two separators */
+        if ((dst = sinkReserve(out, CSTR_FIXED_BUFSIZ * 2 + 3)) == NULL)
+            return SINK_ERR;
+
+        len = 0;
+        if (index == 0) {
+            dst[len++] = 'M';
+            dx = x;
+            dy = y;
+        } else if (index == 1) {
+            dst[len++] = 'l';
+        } else if (!(dx < 0)) {
+            dst[len++] = ' ';
+        }
+        len += cstrFormatFixed(dst + len, dx, 0);
+        if (!(dy < 0))
+            dst[len++] = ' ';
+        len += cstrFormatFixed(dst + len, dy, 0);
+        sinkCommit(out, len);
+    }
 
-    /* TODO: do something better than this!*/
-    if ((outstr = malloc(sizeof(char) * cpArr->len << 10)) == NULL)
-        return NULL;
+    return SINK_OK;
+}
 
-    /* need to know space between x <-> points */
-    xSpace = (double)cDim->width / cpArr->len;
-    acc = 0;
-    offset = 0;
+/**
+ * Formats points `start` to `end` of a line as path commands. They are taken
+ * from `screen` when it holds the line, otherwise they are transformed from
+ * the columns CHART_SCREEN_BLOCK at a time.
+ */
+static int chartFormatPoints(sink *out, chartPointArray *cpArr,
+        chartTransform *tf, chartScreenPoints *screen, chartOptions *options,
+        int start, int end)
+{
+    float xBlock[CHART_SCREEN_BLOCK], yBlock[CHART_SCREEN_BLOCK];
+    float *xs, *ys;
+    double prevX, prevY;
+    int k, n, status;
+
+    /* A relative point is written from the one before it, which can be in
+     * another chunk */
+    prevX = prevY = 0;
+    if (options->pathEncoding == CHART_PATH_RELATIVE && start > 0) {
+        if (screen->x != NULL) {
+            xBlock[0] = screen->x[start - 1];
+            yBlock[0] = screen->y[start - 1];
+        } else {
+            chartTransformPoints(cpArr, tf, start - 1, 1, xBlock, yBlock);
+        }
+        prevX = chartQuantise(xBlock[0], options->pathGrid);
+        prevY = chartQuantise(yBlock[0], options->pathGrid);
+    }
+
+    for (k = start; k < end; k += n) {
+        n = end - k;
+        if (screen->x != NULL) {
+            xs = screen->x + k;
+            ys = screen->y + k;
+        } else {
+            if (n > CHART_SCREEN_BLOCK)
+                n = CHART_SCREEN_BLOCK;
+            chartTransformPoints(cpArr, tf, k, n, xBlock, yBlock);
+            xs = xBlock;
+            ys = yBlock;
+        }
+
+        if (options->pathEncoding == CHART_PATH_RELATIVE)
+            status = chartFormatRelative(out, xs, ys, n, k,
+                    options->pathGrid, &prevX, &prevY);
+        else
+            status = chartFormatAbsolute(out, xs, ys, n, k,
+                    options->precision);
+        if (status == SINK_ERR)
+            return SINK_ERR;
+    }
+
+    return SINK_OK;
+}
+
+typedef struct chartPathChunk {
+    chartPointArray *cpArr;
+    chartTransform *tf;
+    chartScreenPoints *screen;
+    chartOptions *options;
+    int start;
+    int end;
+    int status;
+    int threaded;
+    pthread_t thread;
+    sink out;
+} chartPathChunk;
+
+static void *chartFormatPointsWorker(void *arg) {
+    chartPathChunk *chunk = arg;
+
+    chunk->status = chartFormatPoints(&chunk->out, chunk->cpArr, chunk->tf,
+            chunk->screen, chunk->options, chunk->start, chunk->end);
+    return NULL;
+}
+
+/**
+ * Each thread transforms and formats CHART_THREAD_POINTS points in to its
+ * own buffer, once they have all finished the buffers are written out in
+ * order. This is repeated until all of the points are written, so no more
+ * than `threads * CHART_THREAD_POINTS` points are held in memory as text.
+ * Formatting a point does not depend on its neighbours, so the output is the
+ * same as formatting on one thread.
+ */
+static int chartFormatPointsParallel(sink *out, chartPointArray *cpArr,
+        chartTransform *tf, chartScreenPoints *screen, chartOptions *options,
+        int count)
+{
+    chartPathChunk *chunks, *chunk;
+    int i, start, chunkCount, status, threads;
+
+    threads = options->threads;
+    if ((chunks = calloc(threads, sizeof(chartPathChunk))) == NULL)
+        return SINK_ERR;
+
+    status = SINK_OK;
+
+    for (start = 0; start < count && status == SINK_OK;
+            start += threads * CHART_THREAD_POINTS) {
+        chunkCount = 0;
+
+        for (i = 0; i < threads; ++i) {
+            chunk = &chunks[i];
+            chunk->start = start + i * CHART_THREAD_POINTS;
+            if (chunk->start >= count)
+                break;
+
+            chunk->end = chunk->start + CHART_THREAD_POINTS;
+            if (chunk->end > count)
+                chunk->end = count;
+
+            chunk->cpArr = cpArr;
+            chunk->tf = tf;
+            chunk->screen = screen;
+            chunk->options = options;
+
+            if (sinkInit(&chunk->out, -1) == SINK_ERR) {
+                status = SINK_ERR;
+                break;
+            }
+            chunkCount++;
+
+            /* If we can not get a thread do the work here instead */
+            chunk->threaded = pthread_create(&chunk->thread, NULL,
+                    chartFormatPointsWorker, chunk) == 0;
+            if (!chunk->threaded)
+                chartFormatPointsWorker(chunk);
+        }
+
+        /* All threads need to be joined, even after an error */
+        for (i = 0; i < chunkCount; ++i) {
+            chunk = &chunks[i];
 
-    x = (cDim->marginLeft + (cDim->width - acc)) - cDim->marginRight;
-    y = cDim->height - linearScale(csy, cpArr->yValues[0]);
-    acc += xSpace;
+            if (chunk->threaded)
+                pthread_join(chunk->thread, NULL);
 
-    offset += sprintf(outstr,
-            "<path fill=\"none\" "
-            "stroke=\"%s\" stroke-width=\"1.3\" "
-            "d=\"M%.10f,%.10f",
-            LINE_COLOR, x, y);
+            if (status == SINK_OK && chunk->status == SINK_ERR)
+                status = SINK_ERR;
 
-    for (i = 1; i < cpArr->len; ++i) {
-        x = (cDim->marginLeft + (cDim->width - acc)) - cDim->marginRight;
-        y = cDim->height - linearScale(csy, cpArr->yValues[i]);
+            if (status == SINK_OK)
+                status = sinkWrite(out, chunk->out.buf,
+                        cstrlen(chunk->out.buf));
 
-        offset += sprintf(outstr + offset, "L%.10f,%.10f", x, y);
-        acc += xSpace;
+            sinkRelease(&chunk->out);
+        }
     }
-    offset += sprintf(outstr + offset, "\"/>");
-    outstr[offset] = '\0';
-    *len = offset;
 
-    return outstr;
+    free(chunks);
+    return status;
 }
 
-static char *chartXAxisCreate(chartDimensions *dimensions, int numTicks,
-        chartFormatter *formatter, double *xTicks, int *outlen)
+/**
+ * Writes a path that will be the co-ordinates of where to plot a line on an
+ * SVG chart.
+ */
+static int _chartLinePointsToString(chartPointArray *cpArr,
+        chartDimensions *cDim, chartTransform *tf, chartOptions *options,
+        const char *color, sink *out)
 {
-    char *xAxis, tickBuf[200];
-    double acc, tickSpace;
-    int i;
+    chartScreenPoints screen;
+    int count, status;
+
+    if ((count = chartDownsample(cpArr, tf, cDim, options, &screen)) == -1)
+        return SINK_ERR;
+
+    if (options->pathEncoding == CHART_PATH_RELATIVE) {
+        /* The stroke is scaled down with the path */
+        status = sinkPrintf(out,
+                "<path fill=\"none\" "
+                "stroke=\"%s\" stroke-width=\"%g\" "
+                "transform=\"scale(%.9g)\" d=\"",
+                color, 1.3 * options->pathGrid, 1.0 / options->pathGrid);
+    } else {
+        status = sinkPrintf(out,
+                "<path fill=\"none\" "
+                "stroke=\"%s\" stroke-width=\"1.3\" "
+                "d=\"",
+                color);
+    }
 
-    /* very generous allocation */
-    if ((xAxis = malloc(sizeof(char) * BUFSIZ * numTicks)) == NULL)
-        return NULL;
+    if (status == SINK_OK) {
+        if (options->threads > 1 && count > CHART_THREAD_POINTS)
+            status = chartFormatPointsParallel(out, cpArr, tf, &screen,
+                    options, count);
+        else
+            status = chartFormatPoints(out, cpArr, tf, &screen, options, 0,
+                    count);
+    }
+
+    if (status == SINK_OK)
+        status = sinkWrite(out, "\"/>", 3);
+
+    free(screen.x);
+    free(screen.y);
+    return status;
+}
+
+/* Ticks are placed with the same transform as the line */
+static int chartXAxisCreate(chartDimensions *dimensions, chartTransform *tf,
+        int numTicks, chartFormatter *formatter, double *xTicks,
+        int precision, sink *out)
+{
+    char tickBuf[200], posBuf[CSTR_FIXED_BUFSIZ];
+    int i;
 
     // bottom x axis line
-    *outlen += snprintf(xAxis + *outlen, BUFSIZ,
+    if (sinkPrintf(out,
             "<g>"
             // bottom
             "<line fill=\"none\" stroke=\"%s\" stroke-width=\"1\""
@@ -228,59 +701,50 @@ static char *chartXAxisCreate(chartDimensions *dimensions, int numTicks,
             // bottom positioning
             dimensions->marginLeft - dimensions->marginRight,
             dimensions->width + dimensions->marginLeft - dimensions->marginRight,
-            dimensions->height, dimensions->height);
+            dimensions->height, dimensions->height) == SINK_ERR)
+        return SINK_ERR;
 
-    // The label calculations
-    acc = 0;
-    tickSpace =
-            (double)(dimensions->width + dimensions->marginRight + dimensions->marginRight) /
-            numTicks;
-
-    *outlen += snprintf(xAxis + *outlen, BUFSIZ,
+    if (sinkPrintf(out,
             "<g transform=\"translate(0, %d)\" fill=\"none\" font-size=\"10\""
             " font-family=\"sans-serif\" text-anchor=\"middle\">",
-            dimensions->height);
+            dimensions->height) == SINK_ERR)
+        return SINK_ERR;
 
     // bottom ticks
-    for (i = 0; i < numTicks; ++i) {
-        formatter(xTicks[numTicks - 1 - i], tickBuf);
-        *outlen += snprintf(xAxis + *outlen, BUFSIZ,
-                "<g opactity=\"1\" transform=\"translate(%10.f, 0)\">"
+    for (i = numTicks - 1; i >= 0; --i) {
+        formatter(xTicks[i], tickBuf);
+        cstrFormatFixed(posBuf, tf->xScale * xTicks[i] + tf->xOffset,
+                precision);
+        if (sinkPrintf(out,
+                "<g opactity=\"1\" transform=\"translate(%s, 0)\">"
                 "<line stroke=\"%s\" y2=\"%d\"></line>"
                 "<text style=\"font-size: 8px; text-anchor: end;\" "
                 "fill=\"currentColor\""
                 " transform=\"rotate(-60)\" y=\"%d\" dy=\"-.1em\">%s</text>"
                 "</g>",
-                dimensions->width - acc,
+                posBuf,
                 TICK_COLOR,
                 // the little dash
                 6,
                 // the number by the dash positioning
                 10,
                 // the value to display
-                tickBuf);
-        acc += tickSpace;
+                tickBuf) == SINK_ERR)
+            return SINK_ERR;
     }
 
-    *outlen += snprintf(xAxis + *outlen, 5, "</g>");
-
-    xAxis[*outlen] = '\0';
-    return xAxis;
+    return sinkWrite(out, "</g>", 4);
 }
 
-static char *chartYAxisCreate(chartDimensions *dimensions, int numTicks,
-        chartFormatter *formatter, double *yTicks, int *outlen)
+static int chartYAxisCreate(chartDimensions *dimensions, chartTransform *tf,
+        int numTicks, chartFormatter *formatter, double *yTicks,
+        int precision, sink *out)
 {
-    char *yAxis, tickBuf[200];
-    double acc, tickSpace;
+    char tickBuf[200], posBuf[CSTR_FIXED_BUFSIZ];
     int i;
 
-    /* very generous allocation */
-    if ((yAxis = malloc(sizeof(char) * BUFSIZ * numTicks)) == NULL)
-        return NULL;
-
     // left y axis line
-    *outlen += snprintf(yAxis + *outlen, BUFSIZ,
+    if (sinkPrintf(out,
             "<g>"
             "<line fill=\"none\" stroke=\"%s\" stroke-width=\"1\""
             " x1=\"%d\" x2=\"%d\" y1=\"%d\" y2=\"%d\"></line>"
@@ -288,50 +752,48 @@ static char *chartYAxisCreate(chartDimensions *dimensions, int numTicks,
             AXIS_COLOR,
             dimensions->marginLeft - dimensions->marginRight,
             dimensions->marginLeft - dimensions->marginRight, dimensions->marginTop,
-            dimensions->height);
+            dimensions->height) == SINK_ERR)
+        return SINK_ERR;
 
-    *outlen += snprintf(yAxis + *outlen, BUFSIZ,
+    if (sinkPrintf(out,
             "<g transform=\"translate(%d, 0)\" fill=\"none\" font-size=\"10\""
             " font-family=\"sans-serif\" text-anchor=\"middle\">",
-            dimensions->marginLeft - dimensions->marginRight - 7);
+            dimensions->marginLeft - dimensions->marginRight - 7) == SINK_ERR)
+        return SINK_ERR;
 
-    acc = 0;
-    tickSpace = (((double)dimensions->height) / numTicks) + 0.5;
     // y axis ticks
     for (i = 0; i < numTicks; ++i) {
         formatter(yTicks[i], tickBuf);
-        *outlen += snprintf(yAxis + *outlen, BUFSIZ,
-                "<g opactity=\"1\" transform=\"translate(0, %.10f)\">"
+        cstrFormatFixed(posBuf, tf->yScale * yTicks[i] + tf->yOffset,
+                precision);
+        if (sinkPrintf(out,
+                "<g opactity=\"1\" transform=\"translate(0, %s)\">"
                 "<line stroke=\"%s\" x2=\"%d\"></line>"
                 "<text style=\"font-size: 8px; text-anchor: end;\" "
                 "fill=\"currentColor\" "
                 "dy=\"0.32em\">%s</text>"
                 "</g>",
                 // spacing
-                (dimensions->height - acc),
+                posBuf,
                 TICK_COLOR,
                 // the little dash
                 6,
                 // the value to display
-                tickBuf);
-        acc += tickSpace;
+                tickBuf) == SINK_ERR)
+            return SINK_ERR;
     }
-    *outlen += snprintf(yAxis + *outlen, 5, "</g>");
-
-    yAxis[*outlen] = '\0';
 
-    return yAxis;
+    return sinkWrite(out, "</g>", 4);
 }
 
-static char *_chartLineCreateSVG(chartPointArray *cp_array, chartDimensions *dimensions,
-        chartAxisFormatters *formatters, int width, int height, chartScale **scales,
-        int *outlen)
+static int _chartLineWriteSVG(sink *out, chartPointArray *cp_array,
+        chartDimensions *dimensions, chartAxisFormatters *formatters,
+        chartOptions *options, int width, int height, chartScale **scales)
 {
     chartScale *csy, *csx;
     chartFormatter *yFormatter, *xFormatter;
-    char *svgbuf, *linebuf, *x_axis, *y_axis;
-    int linebuf_len, y_axis_len, x_axis_len;
     double y_ticks[12], x_ticks[5];
+    chartTransform tf;
 
     if (formatters == NULL || (yFormatter = formatters->yFormatter) == NULL)
         yFormatter = _yAxisDefaultFormatter;
@@ -339,63 +801,46 @@ static char *_chartLineCreateSVG(chartPointArray *cp_array, chartDimensions *dim
     if (formatters == NULL || (xFormatter = formatters->xFormatter) == NULL)
         xFormatter = _xAxisDefaultFormatter;
 
-    x_axis = y_axis = svgbuf = linebuf = NULL;
-    linebuf_len = y_axis_len = x_axis_len = 0;
-
     csy = scales[Y_AXIS];
     csx = scales[X_AXIS];
-    csy->rangeMin = 0;
-    csy->rangeMax = dimensions->height - dimensions->marginTop;
+    chartScaleRanges(dimensions, options, csx, csy);
+    chartTransformInit(&tf, dimensions, csx, csy);
 
     _getRange(csx->valMin, csx->valMax, x_ticks, 5);
     _getRange(csy->valMin, csy->valMax, y_ticks, 12);
 
-    if ((x_axis = chartXAxisCreate(dimensions, 5, xFormatter, x_ticks,
-                    &x_axis_len)) == NULL)
-        goto svg_finalise;
-
-    if ((y_axis = chartYAxisCreate(dimensions, 12, yFormatter, y_ticks,
-                    &y_axis_len)) == NULL)
-        goto svg_finalise;
-
-    if ((linebuf = _chartLinePointsToString(cp_array, dimensions, csy,
-                    &linebuf_len)) == NULL)
-        goto svg_finalise;
-
-    if ((svgbuf = malloc(sizeof(char *) *
-                    (BUFSIZ + y_axis_len + x_axis_len + linebuf_len))) == NULL)
-        goto svg_finalise;
-
-    *outlen = snprintf(svgbuf, BUFSIZ << 10,
+    if (sinkPrintf(out,
             "<svg width=\"%d\" height=\"%d\" font-family=\"sans-serif\" "
             "xmlns=\"http://www.w3.org/2000/svg\">"
-            "<rect width=\"100%%\" height=\"100%%\" fill=\"white\" />"
-            "%s%s%s</svg>",
-            width, height, x_axis, y_axis, linebuf);
+            "<rect width=\"100%%\" height=\"100%%\" fill=\"white\" />",
+            width, height) == SINK_ERR)
+        return SINK_ERR;
 
-    svgbuf[*outlen] = '\0';
+    if (chartXAxisCreate(dimensions, &tf, 5, xFormatter, x_ticks,
+                options->precision, out) == SINK_ERR)
+        return SINK_ERR;
 
-svg_finalise:
-    if (x_axis)
-        free(x_axis);
-    if (y_axis)
-        free(y_axis);
-    if (linebuf)
-        free(linebuf);
+    if (chartYAxisCreate(dimensions, &tf, 12, yFormatter, y_ticks,
+                options->precision, out) == SINK_ERR)
+        return SINK_ERR;
 
-    return svgbuf;
+    if (_chartLinePointsToString(cp_array, dimensions, &tf, options,
+                LINE_COLOR, out) == SINK_ERR)
+        return SINK_ERR;
 
-    return NULL;
+    return sinkWrite(out, "</svg>", 6);
 }
 
-char *chartLineCreateSVG(double *x_values, double *y_values, int arr_len,
-        chartAxisFormatters *formatters, int width, int height, int *outlen)
+static int _chartLineRender(sink *out, double *x_values, double *y_values,
+        int arr_len, chartAxisFormatters *formatters, chartOptions *options,
+        int width, int height)
 {
     chartDimensions dimensions;
     chartPointArray cp_array;
     chartScale csy, csx, *scales[2];
 
-    *outlen = 0;
+    if (options == NULL)
+        options = &chartDefaultOptions;
 
     cp_array.len = arr_len;
     cp_array.xValues = x_values;
@@ -414,171 +859,188 @@ char *chartLineCreateSVG(double *x_values, double *y_values, int arr_len,
     scales[X_AXIS] = &csx;
     scales[Y_AXIS] = &csy;
 
-    chartCalculateScales(&dimensions, &cp_array, scales);
+    chartScaleColumns(&cp_array, &csx, &csy);
 
-    return _chartLineCreateSVG(&cp_array, &dimensions, formatters, width,
-            height, scales, outlen);
+    return _chartLineWriteSVG(out, &cp_array, &dimensions, formatters,
+            options, width, height, scales);
 }
 
-/* Takes all of the computed values creating an SVG */
-static char *_chartMultiCreateSVG(int arrayCount, chartPointArray *cpArrays,
-        chartDimensions *dimensions, chartFormatter *yFormatter,
-        chartFormatter *xFormatter, double *xTicks, int xTickCount,
-        double *yTicks, int yTickCount, chartScale *csy, int *outlen)
+char *chartLineCreateSVG(double *x_values, double *y_values, int arr_len,
+        chartAxisFormatters *formatters, chartOptions *options, int width,
+        int height, int *outlen)
 {
-    chartPointArray *cpArr;
-    int i, j, lineBufLen, xAxisLen, yAxisLen, svgbufSize;
-    char **lineChartBuffers, *xAxis, *yAxis, *svgbuf;
+    sink out;
+    char *svgbuf;
 
-    xAxis = NULL;
-    yAxis = NULL;
-    svgbuf = NULL;
-    lineChartBuffers = NULL;
+    *outlen = 0;
 
-    if ((lineChartBuffers = malloc(sizeof(char *) * arrayCount)) == NULL)
+    if (sinkInit(&out, -1) == SINK_ERR)
         return NULL;
 
-    /* Step 1: create line chart string buffers */
-    for (i = 0; i < arrayCount; ++i) {
-        cpArr = &cpArrays[i];
-
-        if ((lineChartBuffers[i] = _chartLinePointsToString(
-                     cpArr, dimensions, csy, &lineBufLen)) == NULL)
-            goto chart_finalise;
+    if (_chartLineRender(&out, x_values, y_values, arr_len, formatters,
+                options, width, height) == SINK_ERR) {
+        sinkRelease(&out);
+        return NULL;
     }
 
-    /* Step 2: create axis buffers */
-    if ((xAxis = chartXAxisCreate(
-                 dimensions, xTickCount, xFormatter, xTicks, &xAxisLen)) == NULL)
-        goto chart_finalise;
-
-    if ((yAxis = chartYAxisCreate(
-                 dimensions, yTickCount, yFormatter, yTicks, &yAxisLen)) == NULL)
-        goto chart_finalise;
-
-    /* Step 3: create SVG buffer */
-    svgbufSize =
-            sizeof(char) * ((lineBufLen * arrayCount) + xAxisLen + yAxisLen);
-
-    if ((svgbuf = malloc(svgbufSize)) == NULL)
-        goto chart_finalise;
+    *outlen = cstrlen(out.buf);
+    svgbuf = sinkDetach(&out);
+    return svgbuf;
+}
 
-    *outlen = snprintf(svgbuf, svgbufSize,
-            "<svg width=\"%d\" height=\"%d\" font-family=\"sans-serif\" "
-            "xmlns=\"http://www.w3.org/2000/svg\">%s%s",
-            dimensions->width, dimensions->height, xAxis, yAxis);
+int chartLineWriteSVG(int fd, double *x_values, double *y_values,
+        int arr_len, chartAxisFormatters *formatters, chartOptions *options,
+        int width, int height)
+{
+    sink out;
+    int ok;
 
-    for (j = 0; j < arrayCount; ++j) {
-        *outlen += snprintf(
-                svgbuf + *outlen, svgbufSize, "%s", lineChartBuffers[j]);
-    }
+    if (sinkInit(&out, fd) == SINK_ERR)
+        return -1;
 
-    *outlen += snprintf(svgbuf + *outlen, 7, "</svg>");
-    svgbuf[*outlen] = '\0';
+    ok = _chartLineRender(&out, x_values, y_values, arr_len, formatters,
+            options, width, height) == SINK_OK && sinkFlush(&out) == SINK_OK;
 
-chart_finalise:
-    if (xAxis)
-        free(xAxis);
-    if (yAxis)
-        free(yAxis);
-    if (arrayCount > 0 && lineChartBuffers != NULL)
-        for (j = 0; j < arrayCount; ++j)
-            free(lineChartBuffers[j]);
-    return svgbuf;
+    sinkRelease(&out);
+    return ok ? 1 : -1;
 }
 
-/**
- * We try and assemble as much as possible in this function to be plotted
- */
-static char *_chartMultiCalculateAxisAndCreateSVG(chartDimensions *dimensions,
-        int arrayCount, chartPointArray *cpArrays, chartFormatter *yFormatter,
-        chartFormatter *xFormatter, int *outlen)
+/* Takes all of the computed values writing an SVG */
+static int _chartMultiWriteSVG(sink *out, int arrayCount,
+        chartPointArray *cpArrays, chartDimensions *dimensions,
+        chartAxisFormatters *formatters, chartOptions *options, int width,
+        int height, chartScale **scales)
 {
-    chartPointArray *cpArr;
-    chartScale csy;
-    int i, j;
-    double x, y;
-    double yTicks[12], xTicks[5], minX, maxX, minY, maxY;
-    char *svgbuf;
+    chartFormatter *yFormatter, *xFormatter;
+    chartScale *csy, *csx;
+    double yTicks[12], xTicks[5];
+    chartTransform tf;
+    int i;
 
-    minX = minY = 100000000;
-    maxX = maxY = -100000000;
+    if (formatters == NULL || (yFormatter = formatters->yFormatter) == NULL)
+        yFormatter = _yAxisDefaultFormatter;
 
-    for (i = 0; i < arrayCount; ++i) {
-        cpArr = &cpArrays[i];
+    if (formatters == NULL || (xFormatter = formatters->xFormatter) == NULL)
+        xFormatter = _xAxisDefaultFormatter;
+
+    csy = scales[Y_AXIS];
+    csx = scales[X_AXIS];
+    chartScaleRanges(dimensions, options, csx, csy);
+    chartTransformInit(&tf, dimensions, csx, csy);
 
-        for (j = 0; j < cpArr->len; ++j) {
-            x = cpArr->xValues[j];
-            y = cpArr->yValues[j];
+    _getRange(csx->valMin, csx->valMax, xTicks, 5);
+    _getRange(csy->valMin, csy->valMax, yTicks, 12);
 
-            if (x > maxX)
-                maxX = x;
-            if (x < minX)
-                minX = x;
-            if (y > maxY)
-                maxY = y;
-            if (y < minY)
-                minY = y;
-        }
-    }
+    if (sinkPrintf(out,
+            "<svg width=\"%d\" height=\"%d\" font-family=\"sans-serif\" "
+            "xmlns=\"http://www.w3.org/2000/svg\">"
+            "<rect width=\"100%%\" height=\"100%%\" fill=\"white\" />",
+            width, height) == SINK_ERR)
+        return SINK_ERR;
 
-    _getRange(minX, maxX, xTicks, 5);
-    _getRange(minY, maxY, yTicks, 12);
+    if (chartXAxisCreate(dimensions, &tf, 5, xFormatter, xTicks,
+                options->precision, out) == SINK_ERR)
+        return SINK_ERR;
 
-    csy.rangeMin = 0;
-    csy.rangeMax = dimensions->height - dimensions->marginTop;
-    csy.valMin = minY;
-    csy.valMax = maxY;
+    if (chartYAxisCreate(dimensions, &tf, 12, yFormatter, yTicks,
+                options->precision, out) == SINK_ERR)
+        return SINK_ERR;
 
-    svgbuf = _chartMultiCreateSVG(arrayCount, cpArrays, dimensions, yFormatter,
-            xFormatter, xTicks, 5, yTicks, 12, &csy, outlen);
+    for (i = 0; i < arrayCount; ++i)
+        if (_chartLinePointsToString(&cpArrays[i], dimensions, &tf, options,
+                    chartSeriesColor(i), out) == SINK_ERR)
+            return SINK_ERR;
 
-    return svgbuf;
+    return sinkWrite(out, "</svg>", 6);
 }
 
-/**
- * This does not yet work
- */
-char *chartLineMultiCreateSVG(int width, int height, int arrayCount,
-        double **x_values_array, double **y_values_array, int array_len,
-        chartAxisFormatters *formatters, int *outlen)
+/* One scale covers every series so they can be compared */
+static int _chartMultiRender(sink *out, int width, int height,
+        int arrayCount, double **x_values_array, double **y_values_array,
+        int array_len, chartAxisFormatters *formatters, chartOptions *options)
 {
-    char *svgbuf;
-    int i;
     chartDimensions dimensions;
-    chartFormatter *yFormatter, *xFormatter;
     chartPointArray *cp_arrays;
+    chartScale csy, csx, *scales[2];
+    int i, status;
+
+    if (options == NULL)
+        options = &chartDefaultOptions;
 
     if ((cp_arrays = malloc(sizeof(chartPointArray) * arrayCount)) == NULL)
-        return NULL;
+        return SINK_ERR;
+
+    dimensions.marginBottom = 80;
+    dimensions.marginLeft = 60;
+    dimensions.marginTop = 10;
+    dimensions.marginRight = 10;
+    dimensions.width = width - dimensions.marginLeft - dimensions.marginRight;
+    dimensions.height = height - dimensions.marginBottom - dimensions.marginTop;
+
+    chartInitScale(&csx);
+    chartInitScale(&csy);
+    scales[X_AXIS] = &csx;
+    scales[Y_AXIS] = &csy;
 
     for (i = 0; i < arrayCount; ++i) {
         cp_arrays[i].len = array_len;
         cp_arrays[i].xValues = x_values_array[i];
         cp_arrays[i].yValues = y_values_array[i];
+        chartScaleColumns(&cp_arrays[i], &csx, &csy);
     }
 
-    if (formatters == NULL || (yFormatter = formatters->yFormatter) == NULL)
-        yFormatter = _yAxisDefaultFormatter;
+    status = _chartMultiWriteSVG(out, arrayCount, cp_arrays, &dimensions,
+            formatters, options, width, height, scales);
 
-    if (formatters == NULL || (xFormatter = formatters->xFormatter) == NULL)
-        xFormatter = _xAxisDefaultFormatter;
+    free(cp_arrays);
+    return status;
+}
 
-    dimensions.marginBottom = 80;
-    dimensions.marginLeft = 60;
-    dimensions.marginTop = 10;
-    dimensions.marginRight = 10;
-    dimensions.width = width - dimensions.marginLeft - dimensions.marginRight;
-    dimensions.height = height - dimensions.marginBottom - dimensions.marginTop;
+char *chartLineMultiCreateSVG(int width, int height, int arrayCount,
+        double **x_values_array, double **y_values_array, int array_len,
+        chartAxisFormatters *formatters, chartOptions *options, int *outlen)
+{
+    char *svgbuf;
+    sink out;
 
-    svgbuf = _chartMultiCalculateAxisAndCreateSVG(
-            &dimensions, arrayCount, cp_arrays, yFormatter, xFormatter, outlen);
+    *outlen = 0;
+    svgbuf = NULL;
 
-    free(cp_arrays);
+    if (sinkInit(&out, -1) == SINK_OK) {
+        if (_chartMultiRender(&out, width, height, arrayCount,
+                    x_values_array, y_values_array, array_len, formatters,
+                    options) == SINK_OK) {
+            *outlen = cstrlen(out.buf);
+            svgbuf = sinkDetach(&out);
+        }
+        sinkRelease(&out);
+    }
 
     return svgbuf;
 }
 
+int chartLineMultiWriteSVG(int fd, int width, int height, int arrayCount,
+        double **x_values_array, double **y_values_array, int array_len,
+        chartAxisFormatters *formatters, chartOptions *options)
+{
+    sink out;
+    int ok;
+
+    if (sinkInit(&out, fd) == SINK_ERR)
+        return -1;
+
+    ok = _chartMultiRender(&out, width, height, arrayCount, x_values_array,
+            y_values_array, array_len, formatters, options) == SINK_OK &&
+            sinkFlush(&out) == SINK_OK;
+
+    sinkRelease(&out);
+    return ok ? 1 : -1;
+}
+
+void chartRelease(char *svgbuf) {
+    cstrRelease(svgbuf);
+}
+
 int chartCreateFile(char *filename, char *svgbuf, int outlen) {
     int total, bytes_left, sent_bytes, fd;
 
@@ -608,31 +1070,85 @@ int chartCreateFile(char *filename, char *svgbuf, int outlen) {
 }
 
 #include <errno.h>
+#include <limits.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 
 #include "cJSON.h"
+#include "cache.h"
 #include "jpath.h"
+#include "source.h"
 static char *progname;
 
+#define PARSER_STREAM   0
+#define PARSER_INDEXED  1
+#define PARSER_PARALLEL 2
+
+#define FORMAT_JSON   0
+#define FORMAT_NDJSON 1
+
+/* Bytes of NDJSON each thread parses at a time */
+#define NDJSON_CHUNK_SIZE (4 * 1024 * 1024)
+
+#define FILL_OK         1
+#define FILL_ERR_PARSE -1
+#define FILL_ERR_ALLOC -2
+#define FILL_ERR_READ  -3
+
 static void printUsage() {
     fprintf(stderr,
             "\nUsage: %s [OPTIONS]\n\n"
-            "Create an svg chart from JSON. JSON must be an array and\n"
-            "both values must be numeric \n\n"
-            " --file <string>                          Path to the json file\n"
-            " --out-file <string>                      Name of outfile\n"
+            "Create an svg chart from JSON. JSON must be an array, or one\n"
+            "value per line with --format ndjson, and both values must be\n"
+            "numeric\n\n"
+            " --file <string>                          Path to the json file, '-'\n"
+            "                                          for stdin\n"
+            " --out-file <string>                      Name of outfile, '-' for"
+            " stdout\n"
             " --x-name <string>                        Name of JSON key for x "
             "values\n"
-            " --x-type <stueing|long|int|float|double>  Data type for x values\n"
+            " --x-type <string|long|int|float|double>  Data type for x values\n"
             " --y-name <string>                        Name of JSON key for y "
-            "values\n"
-            " --y-type <string|long|int|float|double>  Data type for y values\n"
+            "values,\n"
+            "                                          repeat for more lines\n"
+            " --y-type <string|long|int|float|double>  Data type for y values,"
+            " one\n"
+            "                                          per --y-name or one for"
+            " all\n"
             "\nOptional:\n\n"
             "  --width <int>               Width of the chart\n"
             "  --height <int>              Height of the chart\n"
-            "  --reverse <'true'|'false'>  Should the data be plotted in reverse?"
-            " default false\n"
+            "  --reverse <'true'|'false'>  Run the x axis from right to left,\n"
+            "                              largest x on the left. default false\n"
+            "  --format <'json'|'ndjson'>  'ndjson' reads one JSON value per\n"
+            "                              line in chunks on each of\n"
+            "                              --threads. default json\n"
+            "  --batch <string>            Render every chart in a JSON\n"
+            "                              manifest, reading each file once\n"
+            "                              and rendering on --threads\n"
+            "  --cache <'true'|'false'>    Keep the extracted columns in\n"
+            "                              <file>.jcc and use them while the\n"
+            "                              file is unchanged. default false\n"
+            "  --parser <'stream'|'indexed'|'parallel'>  'stream' parses one\n"
+            "                                 element at a time, 'indexed'\n"
+            "                                 parses the whole file in two SIMD\n"
+            "                                 assisted passes, 'parallel'\n"
+            "                                 streams a slice of the array on\n"
+            "                                 each of --threads. default stream\n"
+            "  --threads <int>             Threads used to write the line and\n"
+            "                              for --parser parallel and --format\n"
+            "                              ndjson, default 1\n"
+            "  --precision <int>           Decimal places for co-ordinates\n"
+            "                              in the SVG, default 2\n"
+            "  --downsample <'none'|'m4'|'lttb[:N]'>  'm4' keeps the first,\n"
+            "                                 min, max and last point of each\n"
+            "                                 pixel column, 'lttb' reduces the\n"
+            "                                 line to N points, N defaults to\n"
+            "                                 the chart width. default none\n"
+            "  --path <'absolute'|'relative[:N]'>  'relative' writes the line\n"
+            "                                 as relative moves in steps of\n"
+            "                                 1/N px, N defaults to 4, a few\n"
+            "                                 times smaller. default absolute\n"
             "",
             progname);
     exit(EXIT_FAILURE);
@@ -685,96 +1201,1341 @@ static void printJsonPathError(char *path, int j_type, char *strvalue) {
             path, getValueName(j_type), strvalue);
 }
 
-static void fillAxis(cJSON *json, int arr_len, double *x_values,
-        double *y_values, int x_type, int y_type, char *x_value_name,
-        char *y_value_name, int reverse, chartScale **scales)
-{
-    chartScale *csy, *csx;
-
-    csy = scales[Y_AXIS];
-    csx = scales[X_AXIS];
+/* Make sure the columns can hold `needed` points, doubling the capacity */
+static int growColumns(chartPointArray *cp_array, int *capacity, int needed) {
+    double *xValues, *yValues;
+    int newcap;
 
-    chartInitScale(csy);
-    chartInitScale(csx);
-    cJSON *el;
-    int i;
-    double x, y;
+    if (needed <= *capacity)
+        return 1;
 
-    if (!reverse) {
-        i = 0;
-        cJSON_ArrayForEach(el, json) {
-            if (jpathGetValueFromPath(el, x_value_name, x_type, &x) == JPATH_ERR)
-                printJsonPathError(x_value_name, x_type, el->string);
+    newcap = *capacity == 0 ? 1024 : *capacity;
+    while (newcap < needed)
+        newcap <<= 1;
 
-            if (jpathGetValueFromPath(el, y_value_name, y_type, &y) == JPATH_ERR)
-                printJsonPathError(y_value_name, y_type, el->string);
+    if ((xValues = realloc(cp_array->xValues,
+                    sizeof(double) * newcap)) == NULL)
+        return -1;
+    cp_array->xValues = xValues;
 
-            x_values[i] = (double)x;
-            y_values[i] = (double)y;
+    if ((yValues = realloc(cp_array->yValues,
+                    sizeof(double) * newcap)) == NULL)
+        return -1;
+    cp_array->yValues = yValues;
 
-            if (x > csx->valMax) csx->valMax = x;
-            if (x < csx->valMin) csx->valMin = x;
+    *capacity = newcap;
+    return 1;
+}
 
-            if (y > csy->valMax) csy->valMax = y;
-            if (y < csy->valMin) csy->valMin = y;
-            i++;
-        }
-    } else {
-        i = arr_len;
-        cJSON_ArrayForEach(el, json) {
-            if (jpathGetValueFromPath(el, x_value_name, x_type, &x) == JPATH_ERR)
-                printJsonPathError(x_value_name, x_type, el->string);
+/* Append a point growing the columns as needed, as we stream the array we do
+ * not know up front how many elements there will be */
+static int appendPoint(chartPointArray *cp_array, int *capacity, double x,
+        double y)
+{
+    if (growColumns(cp_array, capacity, cp_array->len + 1) == -1)
+        return -1;
 
-            if (jpathGetValueFromPath(el, y_value_name, y_type, &y) == JPATH_ERR)
-                printJsonPathError(y_value_name, y_type, el->string);
+    cp_array->xValues[cp_array->len] = x;
+    cp_array->yValues[cp_array->len] = y;
+    cp_array->len++;
+    return 1;
+}
 
-            x_values[i-1] = (double)x;
-            y_values[i-1] = (double)y;
+/* Append all of the points in `src` */
+static int appendPoints(chartPointArray *cp_array, int *capacity,
+        chartPointArray *src)
+{
+    if (growColumns(cp_array, capacity, cp_array->len + src->len) == -1)
+        return -1;
 
-            if (x > csx->valMax) csx->valMax = x;
-            if (x < csx->valMin) csx->valMin = x;
-            if (y > csy->valMax) csy->valMax = y;
-            if (y < csy->valMin) csy->valMin = y;
-            --i;
-        }
-    }
+    memcpy(cp_array->xValues + cp_array->len, src->xValues,
+            sizeof(double) * src->len);
+    memcpy(cp_array->yValues + cp_array->len, src->yValues,
+            sizeof(double) * src->len);
+    cp_array->len += src->len;
+    return 1;
 }
 
-/* This assumes an array of json is being passed in, and both must be numeric */
-int main(int argc, char **argv) {
-    progname = argv[0];
+/**
+ * Get the x and y values out of an element, the scales are worked out over
+ * the whole columns once they are filled. A value that is missing or is not
+ * a number is reported and plotted as 0, the same in every reader.
+ */
+static void extractPoint(cJSON *el, jpathExpr *x_expr, jpathExpr *y_expr,
+        char *x_value_name, char *y_value_name, double *x, double *y)
+{
+    if (jpathEvalNumber(x_expr, el, x) == JPATH_ERR) {
+        printJsonPathError(x_value_name, jpathExprType(x_expr), el->string);
+        *x = 0;
+    }
+
+    if (jpathEvalNumber(y_expr, el, y) == JPATH_ERR) {
+        printJsonPathError(y_value_name, jpathExprType(y_expr), el->string);
+        *y = 0;
+    }
+}
+
+/* Widen `cs` to cover `other` */
+static void mergeScale(chartScale *cs, chartScale *other) {
+    if (other->valMax > cs->valMax) cs->valMax = other->valMax;
+    if (other->valMin < cs->valMin) cs->valMin = other->valMin;
+}
+
+/**
+ * Pull one element at a time off of the stream, only the current element is
+ * ever held in memory. Without a stream the elements are the children of an
+ * already parsed array.
+ */
+static int fillAxis(cJSON_Stream *stream, cJSON *array,
+        chartPointArray *cp_array,
+        jpathExpr *x_expr, jpathExpr *y_expr, char *x_value_name,
+        char *y_value_name, chartScale **scales)
+{
+    chartScale *csy, *csx;
+    cJSON *el;
+    int capacity;
+    double x, y;
+
+    csy = scales[Y_AXIS];
+    csx = scales[X_AXIS];
+
+    chartInitScale(csy);
+    chartInitScale(csx);
+
+    capacity = 0;
+    cp_array->len = 0;
+    cp_array->xValues = cp_array->yValues = NULL;
+
+    /* A parsed array knows how long it is, size the columns exactly once */
+    if (array != NULL && (capacity = cJSON_GetArraySize(array)) > 0) {
+        if ((cp_array->xValues = malloc(sizeof(double) * capacity)) == NULL)
+            return FILL_ERR_ALLOC;
+        if ((cp_array->yValues = malloc(sizeof(double) * capacity)) == NULL) {
+            free(cp_array->xValues);
+            cp_array->xValues = NULL;
+            return FILL_ERR_ALLOC;
+        }
+    }
+
+    el = stream ? cJSON_StreamNext(stream) : array->child;
+    while (el != NULL) {
+        extractPoint(el, x_expr, y_expr, x_value_name, y_value_name, &x, &y);
+
+        if (appendPoint(cp_array, &capacity, x, y) == -1)
+            return FILL_ERR_ALLOC;
+
+        el = stream ? cJSON_StreamNext(stream) : el->next;
+    }
+
+    if (stream && cJSON_StreamFailed(stream))
+        return FILL_ERR_PARSE;
+
+    chartScaleColumns(cp_array, csx, csy);
+
+    return FILL_OK;
+}
+
+/* One thread's share of the array, it fills its own slice of the columns */
+typedef struct fillSlice {
+    cJSON_Stream *stream;
+    size_t count;
+    double *xValues;
+    double *yValues;
+    jpathExpr *xExpr;
+    jpathExpr *yExpr;
+    char *xValueName;
+    char *yValueName;
+    chartScale csx;
+    chartScale csy;
+    int status;
+    int threaded;
+    pthread_t thread;
+} fillSlice;
+
+static void *fillSliceWorker(void *arg) {
+    fillSlice *slice = arg;
+    cJSON *el;
+    size_t i;
+    double x, y;
+
+    chartInitScale(&slice->csx);
+    chartInitScale(&slice->csy);
+
+    for (i = 0; (el = cJSON_StreamNext(slice->stream)) != NULL; ++i) {
+        /* Can only happen if the stage one index and parser disagree */
+        if (i == slice->count) {
+            slice->status = FILL_ERR_PARSE;
+            return NULL;
+        }
+
+        extractPoint(el, slice->xExpr, slice->yExpr, slice->xValueName,
+                slice->yValueName, &x, &y);
+
+        slice->xValues[i] = x;
+        slice->yValues[i] = y;
+    }
+
+    if (cJSON_StreamFailed(slice->stream) || i != slice->count) {
+        slice->status = FILL_ERR_PARSE;
+        return NULL;
+    }
+
+    /* Each thread reduces its own part of the columns */
+    reduceMinMax(slice->xValues, slice->count, &slice->csx.valMin,
+            &slice->csx.valMax);
+    reduceMinMax(slice->yValues, slice->count, &slice->csy.valMin,
+            &slice->csy.valMax);
+    slice->status = FILL_OK;
+    return NULL;
+}
+
+/**
+ * The array is split at element boundaries in to a slice per thread. As the
+ * number of elements in each slice is known up front the columns are
+ * allocated once and each thread writes straight in to its own part.
+ */
+static int fillAxisParallel(char *raw_json, size_t len, int threads,
+        chartPointArray *cp_array, jpathExpr *x_expr, jpathExpr *y_expr,
+        char *x_value_name, char *y_value_name, chartScale **scales)
+{
+    cJSON_Stream **streams;
+    fillSlice *slices;
+    size_t *counts, sliceCount, offset, i;
+    int status;
+
+    chartInitScale(scales[X_AXIS]);
+    chartInitScale(scales[Y_AXIS]);
+
+    cp_array->len = 0;
+    cp_array->xValues = cp_array->yValues = NULL;
+
+    streams = malloc(sizeof(cJSON_Stream *) * threads);
+    counts = malloc(sizeof(size_t) * threads);
+    slices = calloc(threads, sizeof(fillSlice));
+    status = FILL_ERR_ALLOC;
+    sliceCount = 0;
+
+    if (streams == NULL || counts == NULL || slices == NULL)
+        goto parallel_finalise;
+
+    if ((sliceCount = cJSON_StreamSplit(raw_json, len, threads, streams,
+                    counts)) == 0) {
+        status = FILL_ERR_PARSE;
+        goto parallel_finalise;
+    }
+
+    offset = 0;
+    for (i = 0; i < sliceCount; ++i)
+        offset += counts[i];
+
+    if (offset > INT_MAX)
+        goto parallel_finalise;
+
+    /* Leave room for at least one point as realloc(ptr, 0) may free */
+    if ((cp_array->xValues = malloc(sizeof(double) * (offset + 1))) == NULL ||
+            (cp_array->yValues = malloc(sizeof(double) * (offset + 1))) == NULL)
+        goto parallel_finalise;
+    cp_array->len = (int)offset;
+
+    offset = 0;
+    for (i = 0; i < sliceCount; ++i) {
+        slices[i].stream = streams[i];
+        slices[i].count = counts[i];
+        slices[i].xValues = cp_array->xValues + offset;
+        slices[i].yValues = cp_array->yValues + offset;
+        slices[i].xExpr = x_expr;
+        slices[i].yExpr = y_expr;
+        slices[i].xValueName = x_value_name;
+        slices[i].yValueName = y_value_name;
+        offset += counts[i];
+
+        /* If we can not get a thread do the work here instead */
+        slices[i].threaded = pthread_create(&slices[i].thread, NULL,
+                fillSliceWorker, &slices[i]) == 0;
+        if (!slices[i].threaded)
+            fillSliceWorker(&slices[i]);
+    }
+
+    status = FILL_OK;
+    for (i = 0; i < sliceCount; ++i) {
+        if (slices[i].threaded)
+            pthread_join(slices[i].thread, NULL);
+
+        if (slices[i].status != FILL_OK) {
+            status = slices[i].status;
+            continue;
+        }
+
+        mergeScale(scales[X_AXIS], &slices[i].csx);
+        mergeScale(scales[Y_AXIS], &slices[i].csy);
+    }
+
+
+parallel_finalise:
+    for (i = 0; i < sliceCount; ++i)
+        cJSON_StreamDelete(streams[i]);
+    free(streams);
+    free(counts);
+    free(slices);
+    return status;
+}
+
+/* A chunk of NDJSON lines, extracted in to its own columns */
+typedef struct fillChunk {
+    cJSON_Stream *stream;
+    chartPointArray columns;
+    int capacity;
+    jpathExpr *xExpr;
+    jpathExpr *yExpr;
+    char *xValueName;
+    char *yValueName;
+    chartScale csx;
+    chartScale csy;
+    int status;
+    int threaded;
+    pthread_t thread;
+} fillChunk;
+
+static void *fillChunkWorker(void *arg) {
+    fillChunk *chunk = arg;
+    cJSON *el;
+    double x, y;
+
+    chartInitScale(&chunk->csx);
+    chartInitScale(&chunk->csy);
+    chunk->columns.len = 0;
+    chunk->status = FILL_OK;
+
+    while ((el = cJSON_StreamNext(chunk->stream)) != NULL) {
+        extractPoint(el, chunk->xExpr, chunk->yExpr, chunk->xValueName,
+                chunk->yValueName, &x, &y);
+
+        if (appendPoint(&chunk->columns, &chunk->capacity, x, y) == -1) {
+            chunk->status = FILL_ERR_ALLOC;
+            return NULL;
+        }
+    }
+
+    if (cJSON_StreamFailed(chunk->stream))
+        chunk->status = FILL_ERR_PARSE;
+    else
+        chartScaleColumns(&chunk->columns, &chunk->csx, &chunk->csy);
+    return NULL;
+}
+
+/**
+ * The file is cut at newlines in to chunks of about NDJSON_CHUNK_SIZE, each
+ * thread parses one chunk at a time and once they are all done the chunks
+ * are appended to the columns in order. Pages of the file that have been
+ * parsed are dropped, so only the chunks in flight are held in memory.
+ */
+static int fillAxisNdjson(char *raw_json, size_t len, int threads,
+        chartPointArray *cp_array, jpathExpr *x_expr, jpathExpr *y_expr,
+        char *x_value_name, char *y_value_name, chartScale **scales)
+{
+    fillChunk *chunks, *chunk;
+    size_t pos, end, released, done, pagesize;
+    char *newline;
+    int i, chunkCount, capacity, status;
+
+    chartInitScale(scales[X_AXIS]);
+    chartInitScale(scales[Y_AXIS]);
+
+    capacity = 0;
+    cp_array->len = 0;
+    cp_array->xValues = cp_array->yValues = NULL;
+
+    if ((chunks = calloc(threads, sizeof(fillChunk))) == NULL)
+        return FILL_ERR_ALLOC;
+
+    pagesize = sysconf(_SC_PAGESIZE);
+    status = FILL_OK;
+    released = 0;
+    pos = 0;
+
+    while (pos < len && status == FILL_OK) {
+        chunkCount = 0;
+
+        for (i = 0; i < threads && pos < len; ++i) {
+            end = pos + NDJSON_CHUNK_SIZE;
+            if (end >= len) {
+                end = len;
+            } else if ((newline = memchr(raw_json + end, '\n', len - end))
+                    != NULL) {
+                end = newline - raw_json + 1;
+            } else {
+                end = len;
+            }
+
+            chunk = &chunks[i];
+            if ((chunk->stream = cJSON_StreamCreateLines(raw_json + pos,
+                            end - pos)) == NULL) {
+                status = FILL_ERR_ALLOC;
+                break;
+            }
+            chunk->xExpr = x_expr;
+            chunk->yExpr = y_expr;
+            chunk->xValueName = x_value_name;
+            chunk->yValueName = y_value_name;
+            chunkCount++;
+            pos = end;
+
+            /* If we can not get a thread do the work here instead */
+            chunk->threaded = pthread_create(&chunk->thread, NULL,
+                    fillChunkWorker, chunk) == 0;
+            if (!chunk->threaded)
+                fillChunkWorker(chunk);
+        }
+
+        for (i = 0; i < chunkCount; ++i) {
+            chunk = &chunks[i];
+
+            if (chunk->threaded)
+                pthread_join(chunk->thread, NULL);
+            cJSON_StreamDelete(chunk->stream);
+
+            if (status != FILL_OK)
+                continue;
+
+            if (chunk->status != FILL_OK) {
+                status = chunk->status;
+                continue;
+            }
+
+            if (chunk->columns.len == 0)
+                continue;
+
+            if (appendPoints(cp_array, &capacity, &chunk->columns) == -1) {
+                status = FILL_ERR_ALLOC;
+                continue;
+            }
+
+            mergeScale(scales[X_AXIS], &chunk->csx);
+            mergeScale(scales[Y_AXIS], &chunk->csy);
+        }
+
+        /* Everything before `pos` has been parsed, let the pages go */
+        done = pos - pos % pagesize;
+        if (done > released) {
+            madvise(raw_json + released, done - released, MADV_DONTNEED);
+            released = done;
+        }
+    }
+
+    for (i = 0; i < threads; ++i) {
+        free(chunks[i].columns.xValues);
+        free(chunks[i].columns.yValues);
+    }
+    free(chunks);
+
+
+    return status;
+}
+
+/* Input that can not be mapped is parsed a run of records at a time, while
+ * the source reads the blocks after it */
+static int fillAxisSource(source *src, int format, chartPointArray *cp_array,
+        jpathExpr *x_expr, jpathExpr *y_expr, char *x_value_name,
+        char *y_value_name, chartScale **scales)
+{
+    cJSON_Stream *stream;
+    cJSON *el;
+    double x, y;
+    size_t len;
+    char *run;
+    int capacity, status, next;
+
+    chartInitScale(scales[X_AXIS]);
+    chartInitScale(scales[Y_AXIS]);
+
+    capacity = 0;
+    cp_array->len = 0;
+    cp_array->xValues = cp_array->yValues = NULL;
+    status = FILL_OK;
+    next = SOURCE_OK;
+
+    while (status == FILL_OK &&
+            (next = sourceNext(src, &run, &len)) == SOURCE_OK) {
+        if (format == FORMAT_NDJSON)
+            stream = cJSON_StreamCreateLines(run, len);
+        else
+            stream = cJSON_StreamCreateSlice(run, len);
+        if (stream == NULL)
+            return FILL_ERR_ALLOC;
+
+        while ((el = cJSON_StreamNext(stream)) != NULL) {
+            extractPoint(el, x_expr, y_expr, x_value_name, y_value_name,
+                    &x, &y);
+
+            if (appendPoint(cp_array, &capacity, x, y) == -1) {
+                status = FILL_ERR_ALLOC;
+                break;
+            }
+        }
+
+        if (status == FILL_OK && cJSON_StreamFailed(stream))
+            status = FILL_ERR_PARSE;
+        cJSON_StreamDelete(stream);
+    }
+
+    if (next == SOURCE_ERR_READ)
+        status = FILL_ERR_READ;
+    else if (next == SOURCE_ERR_PARSE)
+        status = FILL_ERR_PARSE;
+
+    if (status == FILL_OK)
+        chartScaleColumns(cp_array, scales[X_AXIS], scales[Y_AXIS]);
+
+
+    return status;
+}
+
+/* Columns from a cache are used where they are mapped */
+static int fillAxisCache(cacheColumns *cache, chartPointArray *cp_array,
+        chartScale **scales)
+{
+    chartInitScale(scales[X_AXIS]);
+    chartInitScale(scales[Y_AXIS]);
+    scales[X_AXIS]->valMin = cache->xMin;
+    scales[X_AXIS]->valMax = cache->xMax;
+    scales[Y_AXIS]->valMin = cache->yMin;
+    scales[Y_AXIS]->valMax = cache->yMax;
+
+    cp_array->len = cache->len;
+    cp_array->xValues = cache->xValues;
+    cp_array->yValues = cache->yValues;
+
+    return FILL_OK;
+}
+
+static int getFormat(char *format) {
+    if (strncmp(format, "ndjson", 6) == 0) return FORMAT_NDJSON;
+    if (strncmp(format, "json", 4) == 0) return FORMAT_JSON;
+    return -1;
+}
+
+static int getParser(char *parser) {
+    if (strncmp(parser, "stream", 6) == 0) return PARSER_STREAM;
+    if (strncmp(parser, "indexed", 7) == 0) return PARSER_INDEXED;
+    if (strncmp(parser, "parallel", 8) == 0) return PARSER_PARALLEL;
+    return -1;
+}
+
+static int getPrecision(char *precision, chartOptions *options) {
+    char *end;
+    long digits;
+
+    digits = strtol(precision, &end, 10);
+    if (end == precision || *end != '\0' || digits < 0 ||
+            digits > CSTR_FIXED_MAX_PRECISION)
+        return -1;
+
+    options->precision = (int)digits;
+    return 1;
+}
+
+/* Parses <'none'|'m4'|'lttb[:N]'>, returns -1 if invalid */
+static int getDownsample(char *downsample, chartOptions *options) {
+    char *end;
+    long target;
+
+    options->downsampleTarget = 0;
+
+    if (strcmp(downsample, "none") == 0) {
+        options->downsample = CHART_DOWNSAMPLE_NONE;
+        return 1;
+    }
+
+    if (strcmp(downsample, "m4") == 0) {
+        options->downsample = CHART_DOWNSAMPLE_M4;
+        return 1;
+    }
+
+    if (strncmp(downsample, "lttb", 4) != 0)
+        return -1;
+    options->downsample = CHART_DOWNSAMPLE_LTTB;
+
+    if (downsample[4] == '\0')
+        return 1;
+    if (downsample[4] != ':')
+        return -1;
+
+    errno = 0;
+    target = strtol(downsample + 5, &end, 10);
+    if (errno != 0 || end == downsample + 5 || *end != '\0' || target < 3 ||
+            target > INT_MAX)
+        return -1;
+
+    options->downsampleTarget = (int)target;
+    return 1;
+}
+
+static int getPathEncoding(char *encoding, chartOptions *options) {
+    char *end;
+    long grid;
+
+    options->pathGrid = CHART_DEFAULT_PATH_GRID;
 
+    if (strcmp(encoding, "absolute") == 0) {
+        options->pathEncoding = CHART_PATH_ABSOLUTE;
+        return 1;
+    }
+
+    if (strncmp(encoding, "relative", 8) != 0)
+        return -1;
+    options->pathEncoding = CHART_PATH_RELATIVE;
+
+    if (encoding[8] == '\0')
+        return 1;
+    if (encoding[8] != ':')
+        return -1;
+
+    errno = 0;
+    grid = strtol(encoding + 9, &end, 10);
+    if (errno != 0 || end == encoding + 9 || *end != '\0' || grid < 1 ||
+            grid > CHART_MAX_PATH_GRID)
+        return -1;
+
+    options->pathGrid = (int)grid;
+    return 1;
+}
+
+/* The first non whitespace character must open an array */
+static int isJsonArray(char *raw_json, size_t len) {
+    size_t i;
+
+    i = 0;
+    if (len >= 3 && strncmp(raw_json, "\xEF\xBB\xBF", 3) == 0)
+        i = 3;
+
+    while (i < len && (unsigned char)raw_json[i] <= 32)
+        i++;
+
+    return i < len && raw_json[i] == '[';
+}
+
+/* Render a chart to <out_filename>.svg, '-' is stdout. More than one array
+ * is a multi line chart */
+static int writeChart(char *out_filename, chartPointArray *cp_arrays,
+        int count, chartScale **scales, chartOptions *options, int width,
+        int height)
+{
     chartDimensions dimensions;
+    char chartname[200];
+    int outfd, status;
+    sink out;
+
+    dimensions.marginBottom = 80;
+    dimensions.marginLeft = 60;
+    dimensions.marginTop = 10;
+    dimensions.marginRight = 10;
+    dimensions.width = width - dimensions.marginLeft - dimensions.marginRight;
+    dimensions.height = height - dimensions.marginBottom - dimensions.marginTop;
+
+    /* Create SVG Chart, rendering straight in to the file */
+    if (strcmp(out_filename, "-") == 0) {
+        outfd = STDOUT_FILENO;
+    } else {
+        if (snprintf(chartname, sizeof(chartname), "%s.svg", out_filename)
+                >= (int)sizeof(chartname)) {
+            fprintf(stderr, "ERROR: Out file name '%s' is too long\n",
+                    out_filename);
+            return -1;
+        }
+
+        if ((outfd = open(chartname, O_WRONLY | O_CREAT | O_TRUNC, 0666))
+                == -1) {
+            fprintf(stderr, "ERROR: Failed to open file '%s': %s\n",
+                    chartname, strerror(errno));
+            return -1;
+        }
+    }
+
+    status = 1;
+    if (sinkInit(&out, outfd) == SINK_ERR) {
+        fprintf(stderr, "ERROR: Failed to create svg buffer\n");
+        status = -1;
+    } else {
+        if ((count == 1
+                    ? _chartLineWriteSVG(&out, cp_arrays, &dimensions, NULL,
+                        options, width, height, scales)
+                    : _chartMultiWriteSVG(&out, count, cp_arrays,
+                        &dimensions, NULL, options, width, height, scales))
+                    == SINK_ERR ||
+                sinkFlush(&out) == SINK_ERR) {
+            fprintf(stderr, "ERROR: Failed to write chart to file: %s\n",
+                    strerror(errno));
+            status = -1;
+        }
+        sinkRelease(&out);
+    }
+
+    if (outfd != STDOUT_FILENO)
+        close(outfd);
+    return status;
+}
+
+#define BATCH_UNREAD  0
+#define BATCH_READING 1
+#define BATCH_READY   2
+#define BATCH_FAILED  3
+
+/* A value taken from every element of an input, shared by the charts that
+ * plot it */
+typedef struct batchColumn {
+    char *path;
+    int type;
+    jpathExpr *expr;
+    double *values;
+    chartScale scale;
+} batchColumn;
+
+/* A file named by the manifest, it is read once for all of its charts */
+typedef struct batchInput {
+    char *filename;
+    int format;
+    batchColumn *columns;
+    int columnCount;
+    int len;
+    int state;
+    /* Charts from this input that have not been rendered yet */
+    int pending;
+} batchInput;
+
+typedef struct batchChart {
+    char *outFilename;
+    int width;
+    int height;
+    int reverse;
+    int input;
+    int xColumn;
+    /* More than one y column is a multi line chart sharing the x column */
+    int *yColumns;
+    int yCount;
+    /* Where it was in the manifest */
+    int entry;
+    int status;
+} batchChart;
+
+typedef struct batch {
+    batchInput *inputs;
+    int inputCount;
+    batchChart *charts;
+    int chartCount;
+    chartOptions *options;
+    /* Manifest entries that could not be added, each is a failed chart */
+    int invalid;
+    /* The next chart for a worker to take */
+    int next;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} batch;
+
+static char *batchString(cJSON *entry, char *key) {
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(entry, key);
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+static int batchInt(cJSON *entry, char *key, int fallback) {
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(entry, key);
+    return cJSON_IsNumber(item) ? (int)item->valuedouble : fallback;
+}
+
+static int batchAddInput(batch *b, char *filename, int format) {
+    batchInput *inputs, *input;
+    int i;
+
+    for (i = 0; i < b->inputCount; ++i)
+        if (b->inputs[i].format == format &&
+                strcmp(b->inputs[i].filename, filename) == 0)
+            return i;
+
+    if ((inputs = realloc(b->inputs,
+                    sizeof(batchInput) * (b->inputCount + 1))) == NULL)
+        return -1;
+    b->inputs = inputs;
+
+    input = &b->inputs[b->inputCount];
+    memset(input, 0, sizeof(batchInput));
+    input->filename = filename;
+    input->format = format;
+    input->state = BATCH_UNREAD;
+    return b->inputCount++;
+}
+
+static int batchAddColumn(batchInput *input, char *path, int type) {
+    batchColumn *columns, *column;
+    int i;
+
+    for (i = 0; i < input->columnCount; ++i) {
+        column = &input->columns[i];
+        if (column->type == type && strcmp(column->path, path) == 0)
+            return i;
+    }
+
+    if ((columns = realloc(input->columns,
+                    sizeof(batchColumn) * (input->columnCount + 1))) == NULL)
+        return -1;
+    input->columns = columns;
+
+    column = &input->columns[input->columnCount];
+    memset(column, 0, sizeof(batchColumn));
+    if ((column->expr = jpathCompile(path, type)) == NULL)
+        return -1;
+    column->path = path;
+    column->type = type;
+    return input->columnCount++;
+}
+
+static int batchGrow(batchInput *input, int *capacity) {
+    double *values;
+    int i, newcap;
+
+    newcap = *capacity == 0 ? 1024 : *capacity << 1;
+    for (i = 0; i < input->columnCount; ++i) {
+        if ((values = realloc(input->columns[i].values,
+                        sizeof(double) * newcap)) == NULL)
+            return -1;
+        input->columns[i].values = values;
+    }
+
+    *capacity = newcap;
+    return 1;
+}
+
+/* Every column is taken from each element in the one pass */
+static int batchFillStream(batchInput *input, cJSON_Stream *stream,
+        int *capacity)
+{
+    batchColumn *column;
+    cJSON *el;
+    double value;
+    int i;
+
+    while ((el = cJSON_StreamNext(stream)) != NULL) {
+        if (input->len == *capacity && batchGrow(input, capacity) == -1)
+            return FILL_ERR_ALLOC;
+
+        for (i = 0; i < input->columnCount; ++i) {
+            column = &input->columns[i];
+
+            /* As in extractPoint a missing value is plotted as 0 */
+            if (jpathEvalNumber(column->expr, el, &value) == JPATH_ERR) {
+                printJsonPathError(column->path, jpathExprType(column->expr),
+                        el->string);
+                value = 0;
+            }
+
+            column->values[input->len] = value;
+        }
+        input->len++;
+    }
+
+    return cJSON_StreamFailed(stream) ? FILL_ERR_PARSE : FILL_OK;
+}
+
+static int batchReadInput(batchInput *input) {
+    cJSON_Stream *stream;
+    struct stat sb;
+    source src;
+    size_t len;
+    char *raw_json, *run;
+    int i, fd, capacity, status, next;
+
+    for (i = 0; i < input->columnCount; ++i)
+        chartInitScale(&input->columns[i].scale);
+
+    if (strcmp(input->filename, "-") == 0)
+        fd = STDIN_FILENO;
+    else if ((fd = open(input->filename, O_RDONLY)) == -1)
+        return FILL_ERR_READ;
+
+    if (fstat(fd, &sb) == -1) {
+        if (fd != STDIN_FILENO)
+            close(fd);
+        return FILL_ERR_READ;
+    }
+
+    capacity = 0;
+    status = FILL_OK;
+
+    if (S_ISREG(sb.st_mode)) {
+        raw_json = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (raw_json == MAP_FAILED) {
+            status = FILL_ERR_READ;
+        } else {
+            if (input->format == FORMAT_JSON &&
+                    !isJsonArray(raw_json, sb.st_size))
+                status = FILL_ERR_PARSE;
+            else if ((stream = input->format == FORMAT_NDJSON
+                        ? cJSON_StreamCreateLines(raw_json, sb.st_size)
+                        : cJSON_StreamCreate(raw_json, sb.st_size)) == NULL)
+                status = FILL_ERR_ALLOC;
+            else {
+                status = batchFillStream(input, stream, &capacity);
+                cJSON_StreamDelete(stream);
+            }
+            munmap(raw_json, sb.st_size);
+        }
+    } else {
+        sourceInit(&src, fd, input->format == FORMAT_NDJSON ? SOURCE_LINES
+                : SOURCE_ARRAY);
+        next = SOURCE_OK;
+
+        while (status == FILL_OK &&
+                (next = sourceNext(&src, &run, &len)) == SOURCE_OK) {
+            if ((stream = input->format == FORMAT_NDJSON
+                        ? cJSON_StreamCreateLines(run, len)
+                        : cJSON_StreamCreateSlice(run, len)) == NULL) {
+                status = FILL_ERR_ALLOC;
+                break;
+            }
+            status = batchFillStream(input, stream, &capacity);
+            cJSON_StreamDelete(stream);
+        }
+
+        if (next == SOURCE_ERR_READ)
+            status = FILL_ERR_READ;
+        else if (next == SOURCE_ERR_PARSE)
+            status = FILL_ERR_PARSE;
+        sourceRelease(&src);
+    }
+
+    if (fd != STDIN_FILENO)
+        close(fd);
+
+    if (status != FILL_OK)
+        return status;
+
+    for (i = 0; i < input->columnCount; ++i)
+        reduceMinMax(input->columns[i].values, input->len,
+                &input->columns[i].scale.valMin,
+                &input->columns[i].scale.valMax);
+
+    return FILL_OK;
+}
+
+static void batchReleaseInput(batchInput *input) {
+    int i;
+
+    for (i = 0; i < input->columnCount; ++i) {
+        free(input->columns[i].values);
+        input->columns[i].values = NULL;
+    }
+}
+
+static int batchRender(batch *b, batchChart *chart) {
+    batchInput *input;
+    batchColumn *column;
+    chartPointArray *cp_arrays;
+    chartScale csx, csy, *scales[2];
+    chartOptions options;
+    int i, status;
+
+    input = &b->inputs[chart->input];
+    if (input->len == 0) {
+        fprintf(stderr, "ERROR: '%s' has no values\n", input->filename);
+        return -1;
+    }
+
+    if ((cp_arrays = malloc(sizeof(chartPointArray) * chart->yCount))
+            == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate columns: %s\n",
+                strerror(errno));
+        return -1;
+    }
+
+    /* Rendering changes the ranges so each chart has its own scales, the
+     * y scale covers every series */
+    csx = input->columns[chart->xColumn].scale;
+    csy = input->columns[chart->yColumns[0]].scale;
+    scales[X_AXIS] = &csx;
+    scales[Y_AXIS] = &csy;
+
+    for (i = 0; i < chart->yCount; ++i) {
+        column = &input->columns[chart->yColumns[i]];
+        cp_arrays[i].len = input->len;
+        cp_arrays[i].xValues = input->columns[chart->xColumn].values;
+        cp_arrays[i].yValues = column->values;
+        mergeScale(&csy, &column->scale);
+    }
+
+    /* The pool is already using the threads */
+    options = *b->options;
+    options.threads = 1;
+    options.reverse = chart->reverse;
+
+    status = writeChart(chart->outFilename, cp_arrays, chart->yCount, scales,
+            &options, chart->width, chart->height);
+    free(cp_arrays);
+    return status;
+}
+
+/**
+ * Workers take the charts in order, they are sorted by input so only a few
+ * inputs are held at once. The first worker to need an input reads it while
+ * any others that need it wait, and the last to render from it frees it.
+ */
+static void *batchWorker(void *arg) {
+    batch *b = arg;
+    batchChart *chart;
+    batchInput *input;
+    int status;
+
+    for (;;) {
+        pthread_mutex_lock(&b->lock);
+        if (b->next == b->chartCount) {
+            pthread_mutex_unlock(&b->lock);
+            return NULL;
+        }
+        chart = &b->charts[b->next++];
+        input = &b->inputs[chart->input];
+
+        if (input->state == BATCH_UNREAD) {
+            input->state = BATCH_READING;
+            pthread_mutex_unlock(&b->lock);
+
+            status = batchReadInput(input);
+            if (status == FILL_ERR_PARSE)
+                fprintf(stderr, "ERROR: Failed to parse JSON in '%s'\n",
+                        input->filename);
+            else if (status == FILL_ERR_ALLOC)
+                fprintf(stderr, "ERROR: Failed to allocate columns: %s\n",
+                        strerror(errno));
+            else if (status != FILL_OK)
+                fprintf(stderr, "ERROR: Failed to read file '%s': %s\n",
+                        input->filename, strerror(errno));
+
+            pthread_mutex_lock(&b->lock);
+            input->state = status == FILL_OK ? BATCH_READY : BATCH_FAILED;
+            pthread_cond_broadcast(&b->ready);
+        }
+
+        while (input->state == BATCH_READING)
+            pthread_cond_wait(&b->ready, &b->lock);
+        status = input->state;
+        pthread_mutex_unlock(&b->lock);
+
+        chart->status = status == BATCH_READY ? batchRender(b, chart) : -1;
+
+        pthread_mutex_lock(&b->lock);
+        if (--input->pending == 0)
+            batchReleaseInput(input);
+        pthread_mutex_unlock(&b->lock);
+    }
+}
+
+static int batchCompareCharts(const void *a, const void *b) {
+    const batchChart *ca = a, *cb = b;
+
+    if (ca->input != cb->input)
+        return ca->input - cb->input;
+    return ca->entry - cb->entry;
+}
+
+static void batchInit(batch *b, chartOptions *options) {
+    memset(b, 0, sizeof(batch));
+    b->options = options;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->ready, NULL);
+}
+
+/* A y type for each y name, the last one given carries on to the rest */
+static int batchAddChart(batch *b, char *filename, int format,
+        char *out_filename, int width, int height, int reverse, char *x_name,
+        int x_type, char **y_names, int *y_types, int y_count, int type_count,
+        int entry)
+{
+    batchChart *charts, *chart;
+    batchInput *input;
+    int i;
+
+    if ((charts = realloc(b->charts,
+                    sizeof(batchChart) * (b->chartCount + 1))) == NULL)
+        return -1;
+    b->charts = charts;
+
+    chart = &b->charts[b->chartCount];
+    memset(chart, 0, sizeof(batchChart));
+    chart->outFilename = out_filename;
+    chart->width = width;
+    chart->height = height;
+    chart->reverse = reverse;
+    chart->entry = entry;
+    chart->yCount = y_count;
+
+    if ((chart->input = batchAddInput(b, filename, format)) == -1)
+        return -1;
+    input = &b->inputs[chart->input];
+
+    if ((chart->yColumns = malloc(sizeof(int) * y_count)) == NULL)
+        return -1;
+
+    /* Columns already added stay with the input, they are released with it */
+    if ((chart->xColumn = batchAddColumn(input, x_name, x_type)) == -1)
+        goto err;
+
+    for (i = 0; i < y_count; ++i)
+        if ((chart->yColumns[i] = batchAddColumn(input, y_names[i],
+                        y_types[i < type_count ? i : type_count - 1]))
+                    == -1)
+            goto err;
+
+    input->pending++;
+    b->chartCount++;
+    return 1;
+
+err:
+    free(chart->yColumns);
+    chart->yColumns = NULL;
+    return -1;
+}
+
+/* A string, or an array of them, stored in to `out` */
+static int batchStrings(cJSON *entry, char *key, char **out, int max) {
+    cJSON *item, *el;
+    int count;
+
+    item = cJSON_GetObjectItemCaseSensitive(entry, key);
+    if (cJSON_IsString(item)) {
+        out[0] = item->valuestring;
+        return 1;
+    }
+
+    count = 0;
+    if (cJSON_IsArray(item)) {
+        cJSON_ArrayForEach(el, item) {
+            if (!cJSON_IsString(el) || count == max)
+                return 0;
+            out[count++] = el->valuestring;
+        }
+    }
+    return count;
+}
+
+/* Read a chart from an entry of the manifest, printing what is wrong */
+static int batchAddEntry(batch *b, cJSON *entry, int index) {
+    char *filename, *format, *out_filename, *x_name, *x_type, *reverse;
+    char **y_names, **y_type_names;
+    int i, fmt, xt, *y_types, y_count, type_count, rev, status;
+    cJSON *y;
+
+    y = cJSON_GetObjectItemCaseSensitive(entry, "y-name");
+    y_count = cJSON_IsArray(y) && cJSON_GetArraySize(y) > 0
+            ? cJSON_GetArraySize(y) : 1;
+
+    y_names = malloc(sizeof(char *) * y_count);
+    y_type_names = malloc(sizeof(char *) * y_count);
+    y_types = malloc(sizeof(int) * y_count);
+    if (y_names == NULL || y_type_names == NULL || y_types == NULL) {
+        fprintf(stderr, "ERROR: Failed to add manifest entry %d: %s\n",
+                index, strerror(errno));
+        status = -1;
+        goto out;
+    }
+
+    filename = batchString(entry, "file");
+    format = batchString(entry, "format");
+    out_filename = batchString(entry, "out-file");
+    x_name = batchString(entry, "x-name");
+    x_type = batchString(entry, "x-type");
+    y_count = batchStrings(entry, "y-name", y_names, y_count);
+    type_count = batchStrings(entry, "y-type", y_type_names, y_count);
+
+    reverse = batchString(entry, "reverse");
+    rev = cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(entry, "reverse")) ||
+            (reverse && getBoolean(reverse));
+
+    fmt = format ? getFormat(format) : FORMAT_JSON;
+    xt = x_type ? getValueType(x_type) : -1;
+    for (i = 0; i < type_count; ++i)
+        if ((y_types[i] = getValueType(y_type_names[i])) == -1)
+            type_count = 0;
+
+    if (filename == NULL || out_filename == NULL || x_name == NULL ||
+            y_count == 0 || xt == -1 || type_count == 0 || fmt == -1) {
+        fprintf(stderr, "ERROR: Manifest entry %d needs \"file\", "
+                "\"out-file\", \"x-name\", \"x-type\", \"y-name\" and "
+                "\"y-type\"\n", index);
+        status = -1;
+    } else {
+        status = batchAddChart(b, filename, fmt, out_filename,
+                batchInt(entry, "width", 300), batchInt(entry, "height", 200),
+                rev, x_name, xt, y_names, y_types, y_count, type_count,
+                index);
+        if (status == -1)
+            fprintf(stderr, "ERROR: Failed to add manifest entry %d: %s\n",
+                    index, strerror(errno));
+    }
+
+out:
+    free(y_names);
+    free(y_type_names);
+    free(y_types);
+    return status;
+}
+
+static void batchRelease(batch *b) {
+    int i;
+
+    for (i = 0; i < b->inputCount; ++i) {
+        batchReleaseInput(&b->inputs[i]);
+        while (b->inputs[i].columnCount > 0)
+            jpathRelease(b->inputs[i].columns[--b->inputs[i].columnCount].expr);
+        free(b->inputs[i].columns);
+    }
+    for (i = 0; i < b->chartCount; ++i)
+        free(b->charts[i].yColumns);
+    free(b->inputs);
+    free(b->charts);
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->ready);
+}
+
+/* Render all of the charts on the pool, returning the exit status. Entries
+ * that could not be added count as failed */
+static int batchExecute(batch *b) {
+    pthread_t *threads;
+    int i, started, failed, total, nthreads;
+
+    /* Every entry of a manifest may have been bad */
+    if (b->chartCount > 0)
+        qsort(b->charts, b->chartCount, sizeof(batchChart),
+                batchCompareCharts);
+
+    nthreads = b->options->threads;
+    if ((threads = calloc(nthreads, sizeof(pthread_t))) == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate threads: %s\n",
+                strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    /* With no threads the charts are all rendered here */
+    for (started = 0; started < nthreads && started < b->chartCount;
+            ++started)
+        if (pthread_create(&threads[started], NULL, batchWorker, b) != 0)
+            break;
+    if (started == 0)
+        batchWorker(b);
+    for (i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+
+    failed = b->invalid;
+    for (i = 0; i < b->chartCount; ++i)
+        if (b->charts[i].status != 1)
+            failed++;
+    total = b->chartCount + b->invalid;
+    if (failed > 0 && total > 1)
+        fprintf(stderr, "ERROR: %d of %d charts failed\n", failed, total);
+
+    free(threads);
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Renders every chart in a manifest, a JSON array of objects with the same
+ * keys as the command line options e.g. {"file": "data.json", "x-name": ".x",
+ * "x-type": "int", "y-name": ".y", "y-type": "double", "out-file": "y"}.
+ */
+static int batchRun(char *manifest_filename, chartOptions *options) {
+    cJSON *manifest, *entry;
+    struct stat sb;
+    batch b;
+    char *raw;
+    int i, fd, status;
+
+    if ((fd = open(manifest_filename, O_RDONLY)) == -1 ||
+            fstat(fd, &sb) == -1) {
+        fprintf(stderr, "ERROR: Failed to open file '%s': %s\n",
+                manifest_filename, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    raw = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (raw == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Failed to mmap file '%s': %s\n",
+                manifest_filename, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    manifest = cJSON_ParseWithLength(raw, sb.st_size);
+    munmap(raw, sb.st_size);
+    if (!cJSON_IsArray(manifest)) {
+        fprintf(stderr, "ERROR: Manifest must be an array of JSON\n");
+        cJSON_Delete(manifest);
+        return EXIT_FAILURE;
+    }
+
+    batchInit(&b, options);
+
+    /* A bad entry is reported and the rest are still rendered */
+    i = 0;
+    cJSON_ArrayForEach(entry, manifest) {
+        if (batchAddEntry(&b, entry, i++) == -1)
+            b.invalid++;
+    }
+
+    status = batchExecute(&b);
+    batchRelease(&b);
+    cJSON_Delete(manifest);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    progname = argv[0];
+
+    chartOptions options;
     chartScale csx, csy, *scales[2];
     chartPointArray cp_array;
-    cJSON *json;
-    int x_type, y_type, has_err, arr_size, reverse;
-    char *x_value_name, *y_value_name, *filename, *out_filename, *raw_json,
-            *svgbuf;
-    char chartname[200];
-    int i, infd, chartname_len, width, height, svgbuf_len;
-    double *xValues, *yValues;
+    cJSON_Stream *stream;
+    cJSON_Arena *arena;
+    cJSON *array;
+    jpathExpr *x_expr, *y_expr;
+    int x_type, y_type, has_err, parser, format;
+    char *x_value_name, *y_value_name, *filename, *out_filename, *raw_json;
+    char *batch_filename, **y_names;
+    int *y_types, y_count, y_type_count;
+    batch b;
+    int i, infd, width, height, fill_status, batch_status, piped;
+    int use_cache, cached, cache_status;
+    char cachename[PATH_MAX];
+    cacheColumns cache;
+    cacheKey cache_key;
+    source src;
     struct stat sb;
 
     width = 300;
     height = 200;
     has_err = 0;
-    /* We by default do plot the data in the reverse order from how it is collected
-     * from the JSON*/
-    reverse = 1;
+    parser = PARSER_STREAM;
+    format = FORMAT_JSON;
+    use_cache = 0;
+    chartOptionsInit(&options);
     x_type = y_type = -1;
     x_value_name = y_value_name = filename = out_filename = NULL;
+    batch_filename = NULL;
+
+    /* --y-name and --y-type can be repeated, one of each per series */
+    y_names = malloc(sizeof(char *) * argc);
+    y_types = malloc(sizeof(int) * argc);
+    if (y_names == NULL || y_types == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate arguments: %s\n",
+                strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+    y_count = y_type_count = 0;
 
     /* Get command line inputs */
     for (i = 0; i < argc; ++i) {
         if (strncmp(argv[i], "--file", 6) == 0) {
             filename = argv[++i];
         } else if (strncmp(argv[i], "--y-type", 8) == 0) {
-            y_type = getValueType(argv[++i]);
+            y_types[y_type_count++] = getValueType(argv[++i]);
         } else if (strncmp(argv[i], "--x-type", 8) == 0) {
             x_type = getValueType(argv[++i]);
         } else if (strncmp(argv[i], "--y-name", 8) == 0) {
-            y_value_name = argv[++i];
+            y_names[y_count++] = argv[++i];
         } else if (strncmp(argv[i], "--x-name", 8) == 0) {
             x_value_name = argv[++i];
         } else if (strncmp(argv[i], "--out-file", 10) == 0) {
@@ -784,15 +2545,59 @@ int main(int argc, char **argv) {
         } else if (strncmp(argv[i], "--height", 8) == 0) {
             height = atoi(argv[++i]);
         } else if (strncmp(argv[i], "--reverse", 9) == 0) {
-            /**
-             * This is a bit messed up as we by default do plot the data in reverse.
-             * But from a cli users perspective '--reverse true' would be for us
-             * plotting the data in the order we recieved it.
-             */
-            reverse = getBoolean(argv[++i]) == 1 ? 0 : 1;
+            options.reverse = getBoolean(argv[++i]) == 1;
+        } else if (strncmp(argv[i], "--batch", 7) == 0) {
+            batch_filename = argv[++i];
+        } else if (strncmp(argv[i], "--cache", 7) == 0) {
+            use_cache = getBoolean(argv[++i]);
+        } else if (strncmp(argv[i], "--format", 8) == 0) {
+            format = getFormat(argv[++i]);
+        } else if (strncmp(argv[i], "--parser", 8) == 0) {
+            parser = getParser(argv[++i]);
+        } else if (strncmp(argv[i], "--threads", 9) == 0) {
+            if ((options.threads = atoi(argv[++i])) < 1) {
+                fprintf(stderr, "ERROR: --threads must be at least 1\n");
+                has_err = 1;
+            }
+        } else if (strncmp(argv[i], "--precision", 11) == 0) {
+            if (getPrecision(argv[++i], &options) == -1) {
+                fprintf(stderr, "ERROR: --precision must be between 0 and %d\n",
+                        CSTR_FIXED_MAX_PRECISION);
+                has_err = 1;
+            }
+        } else if (strncmp(argv[i], "--downsample", 12) == 0) {
+            if (getDownsample(argv[++i], &options) == -1) {
+                fprintf(stderr, "ERROR: --downsample must be one of "
+                        "<\"none\"|\"m4\"|\"lttb[:N]\">, N at least 3\n");
+                has_err = 1;
+            }
+        } else if (strncmp(argv[i], "--path", 6) == 0) {
+            if (getPathEncoding(argv[++i], &options) == -1) {
+                fprintf(stderr, "ERROR: --path must be one of "
+                        "<\"absolute\"|\"relative[:N]\">, N from 1 to %d\n",
+                        CHART_MAX_PATH_GRID);
+                has_err = 1;
+            }
         }
     }
 
+    /* Each chart in a manifest has its own file, names and types */
+    if (batch_filename != NULL) {
+        if (has_err == 1)
+            printUsage();
+        free(y_names);
+        free(y_types);
+        return batchRun(batch_filename, &options);
+    }
+
+    if (y_count > 0)
+        y_value_name = y_names[0];
+    if (y_type_count > 0)
+        y_type = y_types[0];
+    for (i = 1; i < y_type_count; ++i)
+        if (y_types[i] == -1)
+            y_type = -1;
+
     /* Validate inputs */
     if (x_type == -1)
         has_err = printAxisTypeWarning('x');
@@ -806,12 +2611,43 @@ int main(int argc, char **argv) {
         has_err = printMissingArgWarning("--file");
     if (out_filename == NULL)
         has_err = printMissingArgWarning("--out-file");
+    if (format == -1) {
+        fprintf(stderr, "ERROR: --format must be one of "
+                "<\"json\"|\"ndjson\">\n");
+        has_err = 1;
+    }
+    if (parser == -1) {
+        fprintf(stderr, "ERROR: --parser must be one of "
+                "<\"stream\"|\"indexed\"|\"parallel\">\n");
+        has_err = 1;
+    }
 
     if (has_err == 1)
         printUsage();
 
-    /* Parse JSON */
-    if ((infd = open(filename, O_RDONLY, 0666)) == -1) {
+    /* More than one series shares the x column, they are all taken in the
+     * one walk over the input the same way a manifest's charts are */
+    if (y_count > 1) {
+        batchInit(&b, &options);
+        if (batchAddChart(&b, filename, format, out_filename, width, height,
+                    options.reverse, x_value_name, x_type, y_names, y_types, y_count,
+                    y_type_count, 0) == -1) {
+            fprintf(stderr, "ERROR: Failed to add chart: %s\n",
+                    strerror(errno));
+            batchRelease(&b);
+            exit(EXIT_FAILURE);
+        }
+        free(y_names);
+        free(y_types);
+        batch_status = batchExecute(&b);
+        batchRelease(&b);
+        return batch_status;
+    }
+
+    /* Parse JSON, '-' is stdin */
+    if (strcmp(filename, "-") == 0) {
+        infd = STDIN_FILENO;
+    } else if ((infd = open(filename, O_RDONLY, 0666)) == -1) {
         fprintf(stderr, "ERROR: Failed to open file '%s': %s\n", filename,
                 strerror(errno));
         exit(EXIT_FAILURE);
@@ -823,76 +2659,163 @@ int main(int argc, char **argv) {
         exit(EXIT_FAILURE);
     }
 
-    raw_json = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, infd, 0);
-    if (raw_json == MAP_FAILED) {
-        fprintf(stderr, "ERROR: Failed to mmap file '%s': %s\n", filename,
-                strerror(errno));
-        exit(EXIT_FAILURE);
+    /* Pipes and the like can not be mapped, they are read a block at a time
+     * and the framing is checked as they are */
+    piped = !S_ISREG(sb.st_mode);
+    raw_json = NULL;
+
+    /* Only a named file can have a cache next to it */
+    if (piped || strcmp(filename, "-") == 0 ||
+            snprintf(cachename, sizeof(cachename), "%s%s", filename,
+                CACHE_SUFFIX) >= (int)sizeof(cachename))
+        use_cache = 0;
+
+    /* Columns cached by an earlier run mean the JSON is never looked at */
+    cached = 0;
+    if (use_cache) {
+        cache_key.path = filename;
+        cache_key.sb = &sb;
+        cache_key.xName = x_value_name;
+        cache_key.yName = y_value_name;
+        cache_key.xType = x_type;
+        cache_key.yType = y_type;
+        cache_key.format = format;
+
+        if ((cache_status = cacheLoad(cachename, &cache_key, &cache))
+                == CACHE_OK)
+            cached = 1;
+        else if (cache_status == CACHE_ERR)
+            fprintf(stderr, "WARNING: Failed to read cache '%s': %s\n",
+                    cachename, strerror(errno));
     }
 
-    if ((json = jpathParse(raw_json)) == NULL) {
-        fprintf(stderr, "ERROR: Failed to parse JSON\n");
-        exit(EXIT_FAILURE);
-    }
+    if (!piped && !cached) {
+        raw_json = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, infd, 0);
+        if (raw_json == MAP_FAILED) {
+            fprintf(stderr, "ERROR: Failed to mmap file '%s': %s\n",
+                    filename, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
 
-    if (json->type != cJSON_Array) {
-        fprintf(stderr, "ERROR: JSON must be an array of JSON\n");
-        exit(EXIT_FAILURE);
+        if (format == FORMAT_JSON && !isJsonArray(raw_json, sb.st_size)) {
+            fprintf(stderr, "ERROR: JSON must be an array of JSON\n");
+            exit(EXIT_FAILURE);
+        }
     }
 
-    arr_size = cJSON_GetArraySize(json);
-
-    if ((xValues = malloc(sizeof(double) * arr_size)) == NULL) {
-        fprintf(stderr, "ERROR: Failed to malloc %dbytes for xValues: %s\n",
-                arr_size, strerror(errno));
-        exit(EXIT_FAILURE);
-    }
+    stream = NULL;
+    arena = NULL;
+    array = NULL;
+
+    /* The parallel parser splits up the array once the paths are compiled,
+     * NDJSON is always read in chunks */
+    if (cached || piped || format == FORMAT_NDJSON) {
+        /* Nothing to set up */
+    } else if (parser == PARSER_STREAM) {
+        if ((stream = cJSON_StreamCreate(raw_json, sb.st_size)) == NULL) {
+            fprintf(stderr, "ERROR: Failed to create JSON stream: %s\n",
+                    strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+    } else if (parser == PARSER_INDEXED) {
+        if ((arena = cJSON_ArenaCreate(0)) == NULL) {
+            fprintf(stderr, "ERROR: Failed to create JSON arena: %s\n",
+                    strerror(errno));
+            exit(EXIT_FAILURE);
+        }
 
-    if ((yValues = malloc(sizeof(double) * arr_size)) == NULL) {
-        fprintf(stderr, "ERROR: Failed to malloc %dbytes for yValues: %s\n",
-                arr_size, strerror(errno));
-        exit(EXIT_FAILURE);
+        if ((array = cJSON_ParseIndexed(raw_json, sb.st_size, arena))
+                == NULL) {
+            fprintf(stderr, "ERROR: Failed to parse JSON\n");
+            exit(EXIT_FAILURE);
+        }
     }
 
-    chartInitScale(&csy);
-    chartInitScale(&csx);
-
     scales[X_AXIS] = &csx;
     scales[Y_AXIS] = &csy;
 
-    fillAxis(json, arr_size, xValues, yValues, x_type, y_type, x_value_name,
-            y_value_name, reverse, scales);
-
-    cp_array.len = arr_size;
-    cp_array.xValues = xValues;
-    cp_array.yValues = yValues;
-
-    dimensions.marginBottom = 80;
-    dimensions.marginLeft = 60;
-    dimensions.marginTop = 10;
-    dimensions.marginRight = 10;
-    dimensions.width = width - dimensions.marginLeft - dimensions.marginRight;
-    dimensions.height = height - dimensions.marginBottom - dimensions.marginTop;
-
-    /* Create SVG Chart */
-    chartname_len = snprintf(chartname, sizeof(chartname) * sizeof(char),
-            "%s.svg", out_filename);
-    chartname[chartname_len] = '\0';
+    if ((x_expr = jpathCompile(x_value_name, x_type)) == NULL ||
+            (y_expr = jpathCompile(y_value_name, y_type)) == NULL) {
+        fprintf(stderr, "ERROR: Failed to compile JSON paths: %s\n",
+                strerror(errno));
+        exit(EXIT_FAILURE);
+    }
 
-    if ((svgbuf = _chartLineCreateSVG(&cp_array, &dimensions, NULL, width,
-                 height, scales, &svgbuf_len)) == NULL)
-    {
-        fprintf(stderr, "ERROR: Failed to create svg buffer\n");
+    if (cached) {
+        fill_status = fillAxisCache(&cache, &cp_array, scales);
+    } else if (piped) {
+        sourceInit(&src, infd, format == FORMAT_NDJSON ? SOURCE_LINES
+                : SOURCE_ARRAY);
+        fill_status = fillAxisSource(&src, format, &cp_array, x_expr, y_expr,
+                x_value_name, y_value_name, scales);
+        sourceRelease(&src);
+    } else if (format == FORMAT_NDJSON)
+        fill_status = fillAxisNdjson(raw_json, sb.st_size, options.threads,
+                &cp_array, x_expr, y_expr, x_value_name, y_value_name,
+                scales);
+    else if (parser == PARSER_PARALLEL)
+        fill_status = fillAxisParallel(raw_json, sb.st_size, options.threads,
+                &cp_array, x_expr, y_expr, x_value_name, y_value_name,
+                scales);
+    else
+        fill_status = fillAxis(stream, array, &cp_array, x_expr, y_expr,
+                x_value_name, y_value_name, scales);
+
+    if (fill_status != FILL_OK) {
+        if (fill_status == FILL_ERR_PARSE)
+            fprintf(stderr, "ERROR: Failed to parse JSON\n");
+        else if (fill_status == FILL_ERR_READ)
+            fprintf(stderr, "ERROR: Failed to read file '%s': %s\n",
+                    filename, strerror(errno));
+        else
+            fprintf(stderr, "ERROR: Failed to allocate columns: %s\n",
+                    strerror(errno));
         exit(EXIT_FAILURE);
     }
 
-    if (chartCreateFile(chartname, svgbuf, svgbuf_len) == -1) {
-        fprintf(stderr, "ERROR: Failed to write chart to file: %s\n",
-                strerror(errno));
+    if (stream)
+        cJSON_StreamDelete(stream);
+    if (arena)
+        cJSON_ArenaDelete(arena);
+    jpathRelease(x_expr);
+    jpathRelease(y_expr);
+
+    if (cp_array.len == 0) {
+        if (format == FORMAT_NDJSON)
+            fprintf(stderr, "ERROR: NDJSON has no values\n");
+        else
+            fprintf(stderr, "ERROR: JSON array is empty\n");
         exit(EXIT_FAILURE);
     }
 
-    cJSON_Delete(json);
-    munmap(raw_json, sb.st_size);
+    /* A cache that can not be written only costs the next run its speed */
+    if (use_cache && !cached) {
+        cache.xValues = cp_array.xValues;
+        cache.yValues = cp_array.yValues;
+        cache.len = cp_array.len;
+        cache.xMin = csx.valMin;
+        cache.xMax = csx.valMax;
+        cache.yMin = csy.valMin;
+        cache.yMax = csy.valMax;
+
+        if (cacheStore(cachename, &cache_key, &cache) == CACHE_ERR)
+            fprintf(stderr, "WARNING: Failed to write cache '%s': %s\n",
+                    cachename, strerror(errno));
+    }
+
+    if (writeChart(out_filename, &cp_array, 1, scales, &options, width,
+                height) == -1)
+        exit(EXIT_FAILURE);
+
+    if (cached) {
+        cacheRelease(&cache);
+    } else {
+        free(cp_array.xValues);
+        free(cp_array.yValues);
+    }
+    if (raw_json)
+        munmap(raw_json, sb.st_size);
+    free(y_names);
+    free(y_types);
     return 0;
 }
@@ -39,12 +39,59 @@ typedef struct chartAxisFormatters {
     chartFormatter *yFormatter;
 } chartAxisFormatters;
 
+#define CHART_DOWNSAMPLE_NONE 0
+/* Largest-Triangle-Three-Buckets */
+#define CHART_DOWNSAMPLE_LTTB 1
+/* First, min, max and last point of each pixel column, pixel exact */
+#define CHART_DOWNSAMPLE_M4   2
+
+#define CHART_DEFAULT_PRECISION 2
+
+/* Absolute `L` commands at the chosen precision */
+#define CHART_PATH_ABSOLUTE 0
+/* Relative `l` commands in whole steps of a pixel grid, points falling on
+ * the same step as the one before are dropped */
+#define CHART_PATH_RELATIVE 1
+
+#define CHART_DEFAULT_PATH_GRID 4
+#define CHART_MAX_PATH_GRID     1000
+
+/* Passing NULL for the options uses the defaults set by chartOptionsInit */
+typedef struct chartOptions {
+    int downsample;
+    /* Points to reduce each line to for LTTB, 0 uses the chart width */
+    int downsampleTarget;
+    /* Decimal places for co-ordinates in the SVG, at most 9 */
+    int precision;
+    /* Threads used to format the line, 1 formats on the calling thread */
+    int threads;
+    int pathEncoding;
+    /* Steps per pixel for CHART_PATH_RELATIVE, 4 is a quarter pixel */
+    int pathGrid;
+    /* Run the x axis from right to left, the smallest x on the right */
+    int reverse;
+} chartOptions;
+
+void chartOptionsInit(chartOptions *options);
+
 char *chartLineCreateSVG(double *x_values, double *y_values, int datalen,
-        chartAxisFormatters *formatters, int width, int height, int *outlen);
+        chartAxisFormatters *formatters, chartOptions *options, int width,
+        int height, int *outlen);
+/* Renders straight to `fd` rather than building the SVG in memory */
+int chartLineWriteSVG(int fd, double *x_values, double *y_values, int datalen,
+        chartAxisFormatters *formatters, chartOptions *options, int width,
+        int height);
+/* Every series is drawn against one scale, each in its own colour */
 char *chartLineMultiCreateSVG(int width, int height, int arrayCount,
         double **x_values_array, double **y_values_array, int array_len,
-        chartAxisFormatters *formatters,
+        chartAxisFormatters *formatters, chartOptions *options,
         int *outlen);
+int chartLineMultiWriteSVG(int fd, int width, int height, int arrayCount,
+        double **x_values_array, double **y_values_array, int array_len,
+        chartAxisFormatters *formatters, chartOptions *options);
+
+/* SVG buffers returned by the functions above must be freed with this */
+void chartRelease(char *svgbuf);
 
 /* Write SVG Buffer to a file */
 int chartCreateFile(char *filename, char *svgbuf, int outlen);
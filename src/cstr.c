@@ -27,6 +27,7 @@
  * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
  * POSSIBILITY OF SUCH DAMAGE.
  */
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,7 +38,7 @@ void cstrRelease(void *str) {
     if (str) {
         cstr *s = str;
         s -= CSTR_PAD;
-        s[4] = 'p';
+        s[CSTR_PAD - 1] = 'p';
         free(s);
     }
 } 
@@ -53,10 +54,20 @@ void cstrArrayRelease(cstr **arr, int count) {
 void cstrSetLen(cstr *str, int len) {
     str -= CSTR_PAD;
     memcpy(str, &len, sizeof(int));
-    (str)[4] = '\0';
+    (str)[CSTR_PAD - 1] = '\0';
     str += CSTR_PAD;
 }
 
+static void cstrSetCapacity(cstr *str, int capacity) {
+    memcpy(str - CSTR_PAD + sizeof(int), &capacity, sizeof(int));
+}
+
+int cstrCapacity(cstr *str) {
+    int capacity;
+    memcpy(&capacity, str - CSTR_PAD + sizeof(int), sizeof(int));
+    return capacity;
+}
+
 /* Get the integer out of the string */
 int cstrlen(cstr *str) {
     int len;
@@ -78,14 +89,8 @@ int cstrToString(cstr *str, char *outbuf, int outbuflen) {
 }
 
 /**
- * The first 5 bytes are reserved. 4 for an integer, with the 5th being
- * a null terminator.
- * Resultant buffer looks like this:
- *   LEN     LEN      LEN     LEN    END   STRING    END
- * ['0xFF', '0xFF', '0xFF', '0xFF', '\0', 'a', 'b', '\0'];
- *
- * With the pointer moved forward twice to the start of the string. OR all
- * of the LEN properties together to get the length of the string;
+ * The length starts as 0 with room for `len` characters, see cstr.h for the
+ * layout of the header.
  */
 cstr *cstrEmpty(int len) {
     cstr *out;
@@ -94,6 +99,7 @@ cstr *cstrEmpty(int len) {
         return NULL;
 
     out += CSTR_PAD;
+    cstrSetCapacity(out, len);
     return out;
 }
 
@@ -193,13 +199,14 @@ cstr **cstrSplit(char *to_split, char delimiter, int *count) {
     *count = 0;
     i = 0;
 
-    if ((outArr = malloc(sizeof(char) * 1)) == NULL)
+    if ((outArr = malloc(sizeof(cstr *) * 1)) == NULL)
         return NULL;
 
     while (*ptr != '\0') {
         if (*ptr == delimiter) {
             tmp[i] = '\0';
-            outArr = (char **)realloc(outArr, sizeof(char) * (*count + 1));
+            /* room for this part and the trailing one */
+            outArr = (cstr **)realloc(outArr, sizeof(cstr *) * (*count + 2));
             outArr[*count] = cstrCreate(tmp, i);
 
             i = 0;
@@ -239,3 +246,79 @@ cstr **cstrCastArray(char *original) {
 
     return array;
 }
+
+int cstrFormatFixed(char *buf, double value, int precision) {
+    static const double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+            1e8, 1e9};
+    char digits[CSTR_FIXED_BUFSIZ];
+    unsigned long long fixed;
+    double scaled;
+    int i, len;
+
+    if (precision < 0)
+        precision = 0;
+    if (precision > CSTR_FIXED_MAX_PRECISION)
+        precision = CSTR_FIXED_MAX_PRECISION;
+
+    scaled = (value < 0 ? -value : value) * scales[precision] + 0.5;
+
+    /* Past 2^53 the scaled value is no longer exact, this also catches NaN */
+    if (!(scaled < 9007199254740992.0)) {
+        len = snprintf(buf, CSTR_FIXED_BUFSIZ, "%.*f", precision, value);
+        return len < CSTR_FIXED_BUFSIZ ? len : CSTR_FIXED_BUFSIZ - 1;
+    }
+
+    fixed = (unsigned long long)scaled;
+
+    len = 0;
+    /* Anything that rounds to zero is printed without a sign */
+    if (value < 0 && fixed != 0)
+        buf[len++] = '-';
+
+    /* Digits are generated backwards, fraction first */
+    i = 0;
+    for (; i < precision; ++i) {
+        digits[i] = '0' + fixed % 10;
+        fixed /= 10;
+    }
+    if (precision > 0)
+        digits[i++] = '.';
+    do {
+        digits[i++] = '0' + fixed % 10;
+        fixed /= 10;
+    } while (fixed != 0);
+
+    while (i > 0)
+        buf[len++] = digits[--i];
+    buf[len] = '\0';
+
+    return len;
+}
+
+/* Make sure there is room for `extra` more characters */
+int cstrGrow(cstr **str, int extra) {
+    cstr *grown;
+    int len, capacity;
+
+    len = cstrlen(*str);
+    capacity = cstrCapacity(*str);
+
+    if (extra <= capacity - len)
+        return CSTR_OK;
+
+    if (extra > INT_MAX - len)
+        return CSTR_ERR;
+
+    if (capacity == 0)
+        capacity = 16;
+    while (capacity < len + extra)
+        capacity = capacity > INT_MAX / 2 ? len + extra : capacity << 1;
+
+    if ((grown = realloc(*str - CSTR_PAD, capacity + 1 + CSTR_PAD)) == NULL)
+        return CSTR_ERR;
+
+    grown += CSTR_PAD;
+    cstrSetCapacity(grown, capacity);
+    *str = grown;
+    return CSTR_OK;
+}
@@ -32,7 +32,7 @@
 
 #define CSTR_ERR -1
 #define CSTR_OK   1
-#define CSTR_PAD sizeof(int) + 1
+#define CSTR_PAD (sizeof(int) * 2 + 1)
 
 typedef char cstr;
 
@@ -42,16 +42,16 @@ void cstrSetLen(cstr *str, int len);
 int cstrlen(cstr *str);
 
 /**
- * The first 5 bytes are reserved. 4 for an integer, with the 5th being
- * a null terminator.
+ * The first 9 bytes are reserved. 4 for the length, 4 for the capacity with
+ * the 9th being a null terminator.
  * Resultant buffer looks like this:
- *   LEN     LEN      LEN     LEN    END   STRING    END
- * ['0xFF', '0xFF', '0xFF', '0xFF', '\0', 'a', 'b', '\0'];
+ *   LEN   LEN   LEN   LEN   CAP   CAP   CAP   CAP   END   STRING    END
+ * ['0', '0', '0', '0x02', '0', '0', '0', '0x02', '\0', 'a', 'b', '\0'];
  *
- * With the pointer moved forward twice to the start of the string. OR all
- * of the LEN properties together to get the length of the string;
+ * With the pointer moved forward to the start of the string. The capacity
+ * does not include the trailing null terminator.
  */
-cstr *cstrEmpty();
+cstr *cstrEmpty(int len);
 cstr *cstrCreate(char *tmp, int len);
 cstr *cstrdup(cstr *original);
 cstr **cstrSplit(char *to_split, char delimiter, int *count);
@@ -62,4 +62,24 @@ int cstrIndexOf(cstr *str, char *pattern);
 cstr **cstrCastArray(char *original);
 int cstrToString(cstr *str, char *outbuf, int outbuflen);
 
+/**
+ * cstrGrow makes room for `extra` more bytes after the end of `*str`,
+ * doubling the capacity so filling it a piece at a time is amortised O(1).
+ * `*str` may be moved. Returns CSTR_ERR on allocation failure leaving `*str`
+ * untouched.
+ */
+int cstrCapacity(cstr *str);
+int cstrGrow(cstr **str, int extra);
+
+/**
+ * Writes `value` with `precision` (0-9) decimal places to `buf` followed by a
+ * null terminator, returning the length. The value is rounded to an integer
+ * and printed digit by digit, only NaN, infinity and values past 2^53 once
+ * scaled go through snprintf. `buf` must be at least CSTR_FIXED_BUFSIZ bytes,
+ * output that would be longer is truncated.
+ */
+#define CSTR_FIXED_BUFSIZ 32
+#define CSTR_FIXED_MAX_PRECISION 9
+int cstrFormatFixed(char *buf, double value, int precision);
+
 #endif
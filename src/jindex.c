@@ -0,0 +1,329 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Stage one of the indexed parser, after simdjson's approach.
+ *
+ * The input is processed 64 bytes at a time. Each block is classified into
+ * bitmasks, one bit per byte, for quotes, backslashes, structural characters
+ * and whitespace; with SSE2 or AVX2 where available and a scalar loop
+ * otherwise. Everything after that is plain 64 bit arithmetic:
+ *
+ * - quotes preceded by an odd run of backslashes are escaped and dropped
+ * - a prefix xor over the remaining quotes marks the bytes inside strings,
+ *   carried from one block to the next
+ * - structural characters inside strings are masked out, and opening quotes
+ *   and the first byte of each run of scalar characters are added
+ *
+ * The set bits are then flattened into offsets.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jindex.h"
+#include "simd.h"
+
+#ifdef SIMD_SSE2
+#include <immintrin.h>
+#endif
+
+#define JINDEX_BLOCK 64
+
+typedef struct jindexMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;
+    uint64_t whitespace;
+} jindexMasks;
+
+typedef void jindexClassifier(const unsigned char *block, jindexMasks *m);
+
+static void jindexClassifyScalar(const unsigned char *block, jindexMasks *m) {
+    uint64_t bit;
+    int i;
+
+    memset(m, 0, sizeof(jindexMasks));
+
+    for (i = 0; i < JINDEX_BLOCK; ++i) {
+        bit = 1ULL << i;
+        switch (block[i]) {
+        case '"': m->quote |= bit; break;
+        case '\\': m->backslash |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',':
+            m->op |= bit;
+            break;
+        case ' ': case '\t': case '\n': case '\r':
+            m->whitespace |= bit;
+            break;
+        }
+    }
+}
+
+#ifdef SIMD_SSE2
+static void jindexClassifySSE2(const unsigned char *block, jindexMasks *m) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i carriage = _mm_set1_epi8('\r');
+    __m128i in, folded;
+    uint64_t shift;
+    int i;
+
+    memset(m, 0, sizeof(jindexMasks));
+
+    for (i = 0; i < JINDEX_BLOCK; i += 16) {
+        in = _mm_loadu_si128((const __m128i *)(block + i));
+        /* '[' and ']' are '{' and '}' without the 0x20 bit */
+        folded = _mm_or_si128(in, caseBit);
+        shift = (uint64_t)i;
+
+        m->quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(in, quote)) << shift;
+        m->backslash |= (uint64_t)(uint16_t)_mm_movemask_epi8(
+                _mm_cmpeq_epi8(in, backslash)) << shift;
+        m->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace),
+                        _mm_cmpeq_epi8(folded, closeBrace)),
+                _mm_or_si128(_mm_cmpeq_epi8(in, colon),
+                        _mm_cmpeq_epi8(in, comma)))) << shift;
+        m->whitespace |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(in, space),
+                        _mm_cmpeq_epi8(in, tab)),
+                _mm_or_si128(_mm_cmpeq_epi8(in, newline),
+                        _mm_cmpeq_epi8(in, carriage)))) << shift;
+    }
+}
+#endif
+
+#ifdef SIMD_AVX2
+__attribute__((target("avx2")))
+static void jindexClassifyAVX2(const unsigned char *block, jindexMasks *m) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i carriage = _mm256_set1_epi8('\r');
+    __m256i in, folded;
+    uint64_t shift;
+    int i;
+
+    memset(m, 0, sizeof(jindexMasks));
+
+    for (i = 0; i < JINDEX_BLOCK; i += 32) {
+        in = _mm256_loadu_si256((const __m256i *)(block + i));
+        folded = _mm256_or_si256(in, caseBit);
+        shift = (uint64_t)i;
+
+        m->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(in, quote)) << shift;
+        m->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(in, backslash)) << shift;
+        m->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace),
+                        _mm256_cmpeq_epi8(folded, closeBrace)),
+                _mm256_or_si256(_mm256_cmpeq_epi8(in, colon),
+                        _mm256_cmpeq_epi8(in, comma)))) << shift;
+        m->whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(
+                _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(in, space),
+                                _mm256_cmpeq_epi8(in, tab)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(in, newline),
+                                _mm256_cmpeq_epi8(in, carriage)))) << shift;
+    }
+}
+#endif
+
+static jindexClassifier *const jindexClassifiers[] = {
+    [SIMD_LEVEL_SCALAR] = jindexClassifyScalar,
+#ifdef SIMD_SSE2
+    [SIMD_LEVEL_SSE2] = jindexClassifySSE2,
+#endif
+#ifdef SIMD_AVX2
+    [SIMD_LEVEL_AVX2] = jindexClassifyAVX2,
+#endif
+};
+
+/**
+ * Bits of characters escaped by a backslash. An odd length run of
+ * backslashes escapes the character that follows it, runs may carry over
+ * from the previous block.
+ */
+static uint64_t jindexEscaped(uint64_t backslash, uint64_t *prevEscaped) {
+    const uint64_t evenBits = 0x5555555555555555ULL;
+    uint64_t followsEscape, oddStarts, evenSequences, invert;
+
+    backslash &= ~*prevEscaped;
+    followsEscape = backslash << 1 | *prevEscaped;
+    oddStarts = backslash & ~evenBits & ~followsEscape;
+
+    evenSequences = oddStarts + backslash;
+    *prevEscaped = evenSequences < oddStarts;
+
+    invert = evenSequences << 1;
+    return (evenBits ^ invert) & followsEscape;
+}
+
+/* Each bit becomes the xor of itself and every bit below it */
+static uint64_t jindexPrefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+static int jindexReserve(jindex *idx, size_t needed) {
+    size_t *positions, capacity;
+
+    if (idx->count + needed <= idx->capacity)
+        return 1;
+
+    capacity = idx->capacity << 1;
+    if (capacity < idx->count + needed)
+        capacity = idx->count + needed;
+
+    if ((positions = realloc(idx->positions,
+                    sizeof(size_t) * capacity)) == NULL)
+        return 0;
+
+    idx->positions = positions;
+    idx->capacity = capacity;
+    return 1;
+}
+
+static int jindexTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int n = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+static void jindexFlatten(jindex *idx, uint64_t bits, size_t base) {
+    size_t *out = idx->positions + idx->count;
+
+    while (bits) {
+        *out++ = base + (size_t)jindexTrailingZeros(bits);
+        bits &= bits - 1;
+    }
+
+    idx->count = (size_t)(out - idx->positions);
+}
+
+jindex *jindexBuild(const char *buf, size_t len) {
+    jindexClassifier *classify;
+    jindexMasks m;
+    jindex *idx;
+    unsigned char tail[JINDEX_BLOCK];
+    const unsigned char *block;
+    uint64_t prevEscaped, prevInString, prevScalar, escaped, inString, scalar,
+            structural;
+    size_t offset;
+
+    if ((idx = malloc(sizeof(jindex))) == NULL)
+        return NULL;
+
+    idx->count = 0;
+    idx->capacity = len / 8 + JINDEX_BLOCK;
+    if ((idx->positions = malloc(sizeof(size_t) * idx->capacity)) == NULL) {
+        free(idx);
+        return NULL;
+    }
+
+    classify = jindexClassifiers[simdLevel()];
+    prevEscaped = prevInString = prevScalar = 0;
+
+    for (offset = 0; offset < len; offset += JINDEX_BLOCK) {
+        if (len - offset >= JINDEX_BLOCK) {
+            block = (const unsigned char *)buf + offset;
+        } else {
+            /* pad the last block out with whitespace */
+            memset(tail, ' ', JINDEX_BLOCK);
+            memcpy(tail, buf + offset, len - offset);
+            block = tail;
+        }
+
+        classify(block, &m);
+
+        escaped = jindexEscaped(m.backslash, &prevEscaped);
+        m.quote &= ~escaped;
+
+        /* opening quotes and string contents are set, closing quotes not */
+        inString = jindexPrefixXor(m.quote) ^ prevInString;
+        prevInString = (uint64_t)((int64_t)inString >> 63);
+
+        scalar = ~(m.op | m.whitespace | m.quote | inString);
+        structural = (m.op & ~inString) | (m.quote & inString) |
+                (scalar & ~(scalar << 1 | prevScalar));
+        prevScalar = scalar >> 63;
+
+        if (!jindexReserve(idx, JINDEX_BLOCK)) {
+            jindexRelease(idx);
+            return NULL;
+        }
+        jindexFlatten(idx, structural, offset);
+    }
+
+    /* unterminated string */
+    if (prevInString) {
+        jindexRelease(idx);
+        return NULL;
+    }
+
+    return idx;
+}
+
+void jindexRelease(jindex *idx) {
+    if (idx) {
+        free(idx->positions);
+        free(idx);
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __JINDEX_H__
+#define __JINDEX_H__
+
+#include <stddef.h>
+
+/**
+ * Structural index of a JSON buffer: the offsets, in order, of every
+ * structural character `{}[]:,` and opening quote outside of strings, and the
+ * first byte of every other value (numbers, true, false and null).
+ *
+ * Parsing can then walk this index rather than the input bytes, never having
+ * to look at whitespace or the contents of strings to find the next token.
+ */
+typedef struct jindex {
+    size_t *positions;
+    size_t count;
+    size_t capacity;
+} jindex;
+
+/* Returns NULL on allocation failure or if the input ends inside a string */
+jindex *jindexBuild(const char *buf, size_t len);
+void jindexRelease(jindex *idx);
+
+#endif
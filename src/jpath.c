@@ -38,6 +38,9 @@
 
 #define PATH_INDICIES_SIZE 20
 
+/* cJSON keeps flags such as cJSON_ArenaOwned above the type bits */
+#define jpathJsonType(json) ((json)->type & 0xFF)
+
 
 typedef struct jpath {
     int type;
@@ -53,6 +56,24 @@ typedef struct jpath {
     int idx_count;
 } jpath;
 
+typedef int jpathGetter(cJSON *json, void *result);
+typedef int jpathNumberGetter(cJSON *json, double *result);
+
+/**
+ * A path split and parsed once into a program of steps, with the value getter
+ * chosen up front. Evaluating it against an element does no allocation and
+ * no string parsing.
+ */
+struct jpathExpr {
+    int type;
+    jpath *steps;
+    int stepCount;
+    /* backing storage for the step keys */
+    cstr **parts;
+    jpathGetter *getter;
+    jpathNumberGetter *numberGetter;
+};
+
 void jpathPrintPath(jpath *jp) {
     printf("key: %s\n", jp->key);
     for (int i = 0; i < jp->idx_count; ++i) {
@@ -147,7 +168,7 @@ void jpathPrintValue(cJSON *json) {
         printf("null\n");
         return;
     }
-    switch (json->type) {
+    switch (jpathJsonType(json)) {
     case cJSON_False:
         printf("false\n");
         return;
@@ -177,97 +198,115 @@ void jpathPrintValue(cJSON *json) {
     printf("null\n");
 }
 
-int jpathGetValue(cJSON *json, int valuetype, void *result) {
-    cJSON *desiredJson = json;
+/**
+ * Value getters, one per J_* type so that a compiled path can pick the
+ * conversion once rather than switching on the type for every element.
+ */
+static int jpathGetFloatValue(cJSON *json, void *result) {
+    double *floatResult = result;
 
-    switch (valuetype) {
-        case J_FLOAT: {
-            double *floatResult = result;
-            switch (desiredJson->type) {
-                case cJSON_String: {
-                    *floatResult = (double)atof(desiredJson->valuestring);
-                    return JPATH_OK;
-                }
-                case cJSON_Number: {
-                    *floatResult = desiredJson->valuedouble;
-                    return JPATH_OK;
-                }
-                case cJSON_NULL: {
-                    *floatResult = 0;
-                    return JPATH_OK;
-                }
-                case cJSON_True: {
-                    *floatResult = 1;
-                    return JPATH_OK;
-                }
-                case cJSON_False: {
-                    *floatResult = 0;
-                    return JPATH_OK;
-                }
-                default: goto error;
-            }
-        }
-        case J_LONG: {
-            long *longResult = result;
-            switch (desiredJson->type) {
-                case cJSON_String: {
-                    *longResult = (long)atol(desiredJson->valuestring);
-                    return JPATH_OK;
-                }
-                case cJSON_Number: {
-                    *longResult = (long)desiredJson->valuedouble;
-                    return JPATH_OK;
-                }
-                case cJSON_NULL: {
-                    *longResult = 0;
-                    return JPATH_OK;
-                }
-                case cJSON_True: {
-                    *longResult = 1;
-                    return JPATH_OK;
-                }
-                case cJSON_False: {
-                    *longResult = 0;
-                    return JPATH_OK;
-                }
-                default: goto error;
-            }
-        }
-        case J_STRING: {
-            char **strResult = (char **)result;
-            switch (desiredJson->type) {
-                case cJSON_String: {
-                    *strResult = desiredJson->valuestring;
-                    return JPATH_OK;
-                }
-                case cJSON_Number: {
-                    char buf[100] = {'\0'};
-                    snprintf(buf, 100, "%10.f", desiredJson->valuedouble);
-                    *strResult = buf;
-                    return JPATH_OK;
-                }
-                case cJSON_NULL: {
-                    *strResult = "null";
-                    return JPATH_OK;
-                }
-                case cJSON_True: {
-                    *strResult = "true";
-                    return JPATH_OK;
-                }
-                case cJSON_False: {
-                    *strResult = "false";
-                    return JPATH_OK;
-                }
-                default: goto error;
-            }
-        }
+    switch (jpathJsonType(json)) {
+        case cJSON_String:
+            *floatResult = (double)atof(json->valuestring);
+            return JPATH_OK;
+        case cJSON_Number:
+            *floatResult = json->valuedouble;
+            return JPATH_OK;
+        case cJSON_NULL:
+            *floatResult = 0;
+            return JPATH_OK;
+        case cJSON_True:
+            *floatResult = 1;
+            return JPATH_OK;
+        case cJSON_False:
+            *floatResult = 0;
+            return JPATH_OK;
     }
+    return JPATH_ERR;
+}
 
-error:
-    result = NULL;
+static int jpathGetLongValue(cJSON *json, void *result) {
+    long *longResult = result;
+
+    switch (jpathJsonType(json)) {
+        case cJSON_String:
+            *longResult = (long)atol(json->valuestring);
+            return JPATH_OK;
+        case cJSON_Number:
+            *longResult = (long)json->valuedouble;
+            return JPATH_OK;
+        case cJSON_NULL:
+            *longResult = 0;
+            return JPATH_OK;
+        case cJSON_True:
+            *longResult = 1;
+            return JPATH_OK;
+        case cJSON_False:
+            *longResult = 0;
+            return JPATH_OK;
+    }
     return JPATH_ERR;
 }
 
+static int jpathGetStringValue(cJSON *json, void *result) {
+    char **strResult = (char **)result;
+
+    switch (jpathJsonType(json)) {
+        case cJSON_String:
+            *strResult = json->valuestring;
+            return JPATH_OK;
+        case cJSON_Number: {
+            char buf[100] = {'\0'};
+            snprintf(buf, 100, "%10.f", json->valuedouble);
+            *strResult = buf;
+            return JPATH_OK;
+        }
+        case cJSON_NULL:
+            *strResult = "null";
+            return JPATH_OK;
+        case cJSON_True:
+            *strResult = "true";
+            return JPATH_OK;
+        case cJSON_False:
+            *strResult = "false";
+            return JPATH_OK;
+    }
+    return JPATH_ERR;
+}
+
+/* As above but always producing a double, for plotting */
+static int jpathGetFloatNumber(cJSON *json, double *result) {
+    return jpathGetFloatValue(json, result);
+}
+
+static int jpathGetLongNumber(cJSON *json, double *result) {
+    long l;
+
+    if (jpathGetLongValue(json, &l) == JPATH_ERR)
+        return JPATH_ERR;
+
+    *result = (double)l;
+    return JPATH_OK;
+}
+
+static jpathGetter *jpathGetterForType(int valuetype) {
+    switch (valuetype) {
+        case J_FLOAT: return jpathGetFloatValue;
+        case J_LONG: return jpathGetLongValue;
+        case J_STRING: return jpathGetStringValue;
+    }
+    return NULL;
+}
+
+int jpathGetValue(cJSON *json, int valuetype, void *result) {
+    jpathGetter *getter;
+
+    if ((getter = jpathGetterForType(valuetype)) == NULL)
+        return JPATH_ERR;
+
+    return getter(json, result);
+}
+
 /**
  * For handling array access for example:
  *
@@ -277,30 +316,31 @@ error:
  * to get the second element of the first row
  */
 void jpathTraverseArray(cJSON **cur, jpath *jp) {
-    int arrsize, i;
+    int arrsize, idx, i;
 
     for (i = 0; i < jp->idx_count; ++i) {
-        if ((*cur)->type != cJSON_Array) {
+        if (jpathJsonType(*cur) != cJSON_Array) {
             fprintf(stderr, "Error: expected Array recieved: %s\n",
-                jpathTypeString((*cur)->type));
+                jpathTypeString(jpathJsonType(*cur)));
             *cur = NULL;
             return;
         }
         arrsize = cJSON_GetArraySize(*cur);
+        idx = jp->array_indicies[i];
 
-        if (i >= arrsize || i < 0) {
+        if (idx >= arrsize || idx < 0) {
             fprintf(
-                stderr, "idx out of bounds: %d array size: %d\n", i, arrsize);
+                stderr, "idx out of bounds: %d array size: %d\n", idx, arrsize);
             *cur = NULL;
             return;
         } else {
-            *cur = cJSON_GetArrayItem(*cur, jp->array_indicies[i]);
+            *cur = cJSON_GetArrayItem(*cur, idx);
         }
     }
 }
 
 int jpathVisit(cJSON **cur, jpath *jp, cJSON *tmp) {
-    switch ((*cur)->type) {
+    switch (jpathJsonType(*cur)) {
     case cJSON_False:
     case cJSON_True:
     case cJSON_NULL:
@@ -315,7 +355,7 @@ int jpathVisit(cJSON **cur, jpath *jp, cJSON *tmp) {
         tmp = cJSON_GetObjectItemCaseSensitive(*cur, jp->key);
         if (tmp == NULL)
             return 1;
-        if ((*cur)->type == cJSON_Array && jp->idx_count > 0)
+        if (jpathJsonType(*cur) == cJSON_Array && jp->idx_count > 0)
             jpathTraverseArray(cur, jp);
         break;
     case cJSON_Raw:
@@ -337,7 +377,7 @@ cJSON *jpathGet(cJSON *json, char *path) {
 
     for (int i = 0; i < partCount; ++i) {
         jpathParsePath(parts[i], &jp);
-        switch (json->type) {
+        switch (jpathJsonType(json)) {
             case cJSON_False:
             case cJSON_True:
             case cJSON_NULL:
@@ -352,7 +392,7 @@ cJSON *jpathGet(cJSON *json, char *path) {
                 json = cJSON_GetObjectItemCaseSensitive(json, jp.key);
                 if (json == NULL)
                     goto notfound;
-                if (json->type == cJSON_Array && jp.idx_count > 0)
+                if (jpathJsonType(json) == cJSON_Array && jp.idx_count > 0)
                     jpathTraverseArray(&json, &jp);
                 break;
             case cJSON_Raw:
@@ -377,6 +417,93 @@ int jpathGetValueFromPath(cJSON *json, char *path, int type, void *retval) {
     return jpathGetValue(needle, type, retval);
 }
 
+jpathExpr *jpathCompile(char *path, int type) {
+    jpathExpr *expr;
+    int i;
+
+    if ((expr = calloc(1, sizeof(jpathExpr))) == NULL)
+        return NULL;
+
+    expr->type = type;
+    if ((expr->getter = jpathGetterForType(type)) == NULL)
+        goto error;
+
+    /* numeric strings are plotted as floats */
+    switch (type) {
+        case J_LONG: expr->numberGetter = jpathGetLongNumber; break;
+        default: expr->numberGetter = jpathGetFloatNumber; break;
+    }
+
+    if (path[0] == '.')
+        path++;
+
+    if ((expr->parts = cstrSplit(path, '.', &expr->stepCount)) == NULL)
+        goto error;
+
+    if ((expr->steps = malloc(sizeof(jpath) * expr->stepCount)) == NULL)
+        goto error;
+
+    for (i = 0; i < expr->stepCount; ++i)
+        jpathParsePath(expr->parts[i], &expr->steps[i]);
+
+    return expr;
+
+error:
+    jpathRelease(expr);
+    return NULL;
+}
+
+/* Walk the compiled steps, this mirrors `jpathGet` */
+static cJSON *jpathEvalSteps(jpathExpr *expr, cJSON *json) {
+    jpath *jp;
+    int i;
+
+    for (i = 0; i < expr->stepCount && json != NULL; ++i) {
+        jp = &expr->steps[i];
+        switch (jpathJsonType(json)) {
+            case cJSON_Array:
+                jpathTraverseArray(&json, jp);
+                break;
+            case cJSON_Object:
+                json = cJSON_GetObjectItemCaseSensitive(json, jp->key);
+                if (json != NULL && jpathJsonType(json) == cJSON_Array &&
+                        jp->idx_count > 0)
+                    jpathTraverseArray(&json, jp);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return json;
+}
+
+int jpathEval(jpathExpr *expr, cJSON *json, void *retval) {
+    if ((json = jpathEvalSteps(expr, json)) == NULL)
+        return JPATH_ERR;
+
+    return expr->getter(json, retval);
+}
+
+int jpathEvalNumber(jpathExpr *expr, cJSON *json, double *retval) {
+    if ((json = jpathEvalSteps(expr, json)) == NULL)
+        return JPATH_ERR;
+
+    return expr->numberGetter(json, retval);
+}
+
+int jpathExprType(jpathExpr *expr) {
+    return expr->type;
+}
+
+void jpathRelease(jpathExpr *expr) {
+    if (expr) {
+        cstrArrayRelease(expr->parts, expr->stepCount);
+        free(expr->steps);
+        free(expr);
+    }
+}
+
 cJSON *jpathParse(char *rawjson) {
     if (rawjson == NULL)
         return NULL;
@@ -39,6 +39,9 @@
 #define JPATH_OK 1
 #define JPATH_ERR -1
 
+/* A path compiled once, to be evaluated against many elements */
+typedef struct jpathExpr jpathExpr;
+
 cJSON *jpathGet(cJSON *json, char *path);
 cJSON *jpathParse(char *rawjson);
 void jpathPrintValue(cJSON *json);
@@ -47,6 +50,13 @@ void jpathPrintJson(cJSON *json);
 int jpathGetValue(cJSON *json, int valuetype, void *result);
 int jpathGetValueFromPath(cJSON *json, char *path, int type, void *retval);
 
+jpathExpr *jpathCompile(char *path, int type);
+int jpathEval(jpathExpr *expr, cJSON *json, void *retval);
+/* The value is always returned as a double, J_STRING values are parsed */
+int jpathEvalNumber(jpathExpr *expr, cJSON *json, double *retval);
+int jpathExprType(jpathExpr *expr);
+void jpathRelease(jpathExpr *expr);
+
 #define jpathGetString(json, path, retval) \
     jpathGetValueFromPath((json), (path), J_STRING, (retval))
 
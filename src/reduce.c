@@ -0,0 +1,145 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Min and max over a column of doubles, used for every chart's scales.
+ *
+ * The vector kernels keep two accumulators each of min and max so that
+ * consecutive compares do not wait on one another. `minpd` and `maxpd`
+ * return their second operand when either is NaN, so with the accumulator
+ * second a NaN in the column never replaces what has been seen so far,
+ * matching the scalar compares which are false for NaN.
+ */
+#include <stddef.h>
+
+#include "reduce.h"
+#include "simd.h"
+
+#ifdef SIMD_SSE2
+#include <immintrin.h>
+#endif
+
+typedef void reduceKernel(const double *values, size_t len, double *min,
+        double *max);
+
+static void reduceMinMaxScalar(const double *values, size_t len, double *min,
+        double *max)
+{
+    double lo, hi, v;
+    size_t i;
+
+    lo = *min;
+    hi = *max;
+    for (i = 0; i < len; ++i) {
+        v = values[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    *min = lo;
+    *max = hi;
+}
+
+#ifdef SIMD_SSE2
+static void reduceMinMaxSSE2(const double *values, size_t len, double *min,
+        double *max)
+{
+    __m128d lo0, lo1, hi0, hi1, a, b;
+    double out[2];
+    size_t i;
+
+    lo0 = lo1 = _mm_set1_pd(*min);
+    hi0 = hi1 = _mm_set1_pd(*max);
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        a = _mm_loadu_pd(values + i);
+        b = _mm_loadu_pd(values + i + 2);
+        lo0 = _mm_min_pd(a, lo0);
+        lo1 = _mm_min_pd(b, lo1);
+        hi0 = _mm_max_pd(a, hi0);
+        hi1 = _mm_max_pd(b, hi1);
+    }
+
+    _mm_storeu_pd(out, _mm_min_pd(lo0, lo1));
+    *min = out[0] < out[1] ? out[0] : out[1];
+    _mm_storeu_pd(out, _mm_max_pd(hi0, hi1));
+    *max = out[0] > out[1] ? out[0] : out[1];
+
+    reduceMinMaxScalar(values + i, len - i, min, max);
+}
+#endif
+
+#ifdef SIMD_AVX2
+__attribute__((target("avx2")))
+static void reduceMinMaxAVX2(const double *values, size_t len, double *min,
+        double *max)
+{
+    __m256d lo0, lo1, hi0, hi1, a, b;
+    double out[4];
+    size_t i;
+    int j;
+
+    lo0 = lo1 = _mm256_set1_pd(*min);
+    hi0 = hi1 = _mm256_set1_pd(*max);
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        a = _mm256_loadu_pd(values + i);
+        b = _mm256_loadu_pd(values + i + 4);
+        lo0 = _mm256_min_pd(a, lo0);
+        lo1 = _mm256_min_pd(b, lo1);
+        hi0 = _mm256_max_pd(a, hi0);
+        hi1 = _mm256_max_pd(b, hi1);
+    }
+
+    _mm256_storeu_pd(out, _mm256_min_pd(lo0, lo1));
+    for (j = 0; j < 4; ++j)
+        if (out[j] < *min) *min = out[j];
+    _mm256_storeu_pd(out, _mm256_max_pd(hi0, hi1));
+    for (j = 0; j < 4; ++j)
+        if (out[j] > *max) *max = out[j];
+
+    reduceMinMaxScalar(values + i, len - i, min, max);
+}
+#endif
+
+static reduceKernel *const reduceKernels[] = {
+    [SIMD_LEVEL_SCALAR] = reduceMinMaxScalar,
+#ifdef SIMD_SSE2
+    [SIMD_LEVEL_SSE2] = reduceMinMaxSSE2,
+#endif
+#ifdef SIMD_AVX2
+    [SIMD_LEVEL_AVX2] = reduceMinMaxAVX2,
+#endif
+};
+
+void reduceMinMax(const double *values, size_t len, double *min,
+        double *max)
+{
+    reduceKernels[simdLevel()](values, len, min, max);
+}
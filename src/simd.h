@@ -0,0 +1,57 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __SIMD_H__
+#define __SIMD_H__
+
+/**
+ * Which vector kernels are built, shared by every module that has them.
+ * SSE2 is part of x86-64 so its kernels run anywhere the build does. AVX2
+ * kernels are compiled with a target attribute and only called when
+ * simdLevel() finds the CPU has it, the rest of the build stays baseline
+ * x86-64. Define SIMD_NO_SIMD to build only the scalar kernels.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2__)) &&        \
+        !defined(SIMD_NO_SIMD)
+#define SIMD_SSE2 1
+#endif
+
+#if defined(SIMD_SSE2) && defined(__x86_64__)
+#define SIMD_AVX2 1
+#endif
+
+#define SIMD_LEVEL_SCALAR 0
+#define SIMD_LEVEL_SSE2 1
+#define SIMD_LEVEL_AVX2 2
+
+/* The widest kernels that are built and that this CPU runs, the CPU is only
+ * asked the first time */
+int simdLevel(void);
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "sink.h"
+
+int sinkInit(sink *s, int fd) {
+    s->fd = fd;
+    if ((s->buf = cstrEmpty(fd == -1 ? BUFSIZ : SINK_BUFSIZ)) == NULL)
+        return SINK_ERR;
+    return SINK_OK;
+}
+
+int sinkWritev(int fd, struct iovec *iov, int iovcnt) {
+    ssize_t written;
+
+    while (iovcnt > 0) {
+        if ((written = writev(fd, iov, iovcnt)) == -1) {
+            if (errno == EINTR)
+                continue;
+            return SINK_ERR;
+        }
+
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return SINK_OK;
+}
+
+int sinkFlush(sink *s) {
+    struct iovec iov;
+
+    if (s->fd == -1 || cstrlen(s->buf) == 0)
+        return SINK_OK;
+
+    iov.iov_base = s->buf;
+    iov.iov_len = cstrlen(s->buf);
+
+    if (sinkWritev(s->fd, &iov, 1) == SINK_ERR)
+        return SINK_ERR;
+
+    cstrSetLen(s->buf, 0);
+    return SINK_OK;
+}
+
+char *sinkReserve(sink *s, int len) {
+    if (s->fd != -1 && cstrCapacity(s->buf) - cstrlen(s->buf) < len &&
+            sinkFlush(s) == SINK_ERR)
+        return NULL;
+
+    /* Only grows a file sink if `len` is bigger than the whole buffer */
+    if (cstrGrow(&s->buf, len) == CSTR_ERR) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    return s->buf + cstrlen(s->buf);
+}
+
+void sinkCommit(sink *s, int len) {
+    cstrSetLen(s->buf, cstrlen(s->buf) + len);
+}
+
+int sinkWrite(sink *s, char *data, int len) {
+    struct iovec iov[2];
+    char *dst;
+
+    /* Too big to be worth copying, write what is buffered along with it */
+    if (s->fd != -1 && len >= SINK_BUFSIZ) {
+        iov[0].iov_base = s->buf;
+        iov[0].iov_len = cstrlen(s->buf);
+        iov[1].iov_base = data;
+        iov[1].iov_len = len;
+
+        if (sinkWritev(s->fd, iov, 2) == SINK_ERR)
+            return SINK_ERR;
+
+        cstrSetLen(s->buf, 0);
+        return SINK_OK;
+    }
+
+    if ((dst = sinkReserve(s, len)) == NULL)
+        return SINK_ERR;
+
+    memcpy(dst, data, len);
+    sinkCommit(s, len);
+    return SINK_OK;
+}
+
+int sinkPrintf(sink *s, const char *fmt, ...) {
+    va_list ap;
+    int len, avail;
+    char *dst;
+
+    avail = cstrCapacity(s->buf) - cstrlen(s->buf);
+
+    /* Try to format straight in to the free space first */
+    va_start(ap, fmt);
+    len = vsnprintf(s->buf + cstrlen(s->buf), avail + 1, fmt, ap);
+    va_end(ap);
+
+    if (len < 0)
+        return SINK_ERR;
+
+    if (len > avail) {
+        if ((dst = sinkReserve(s, len)) == NULL)
+            return SINK_ERR;
+
+        va_start(ap, fmt);
+        vsnprintf(dst, len + 1, fmt, ap);
+        va_end(ap);
+    }
+
+    sinkCommit(s, len);
+    return SINK_OK;
+}
+
+cstr *sinkDetach(sink *s) {
+    cstr *buf;
+
+    buf = s->buf;
+    s->buf = NULL;
+    return buf;
+}
+
+void sinkRelease(sink *s) {
+    cstrRelease(s->buf);
+    s->buf = NULL;
+}
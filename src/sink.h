@@ -0,0 +1,73 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __SINK_H__
+#define __SINK_H__
+
+#include <sys/uio.h>
+
+#include "cstr.h"
+
+#define SINK_OK 1
+#define SINK_ERR -1
+
+/* Output buffered before it is written to a file descriptor */
+#define SINK_BUFSIZ (128 * 1024)
+
+/**
+ * Somewhere to write output to. With a file descriptor the buffer stays
+ * SINK_BUFSIZ and is written out whenever it fills up, with a file
+ * descriptor of -1 everything is kept in memory and can be taken with
+ * sinkDetach. Errors are SINK_ERR with errno set.
+ */
+typedef struct sink {
+    int fd;
+    cstr *buf;
+} sink;
+
+int sinkInit(sink *s, int fd);
+int sinkWrite(sink *s, char *data, int len);
+int sinkPrintf(sink *s, const char *fmt, ...)
+        __attribute__((format(printf, 2, 3)));
+
+/**
+ * Returns room for at least `len` bytes to be written in to directly, then
+ * sinkCommit says how many were used. NULL on failure.
+ */
+char *sinkReserve(sink *s, int len);
+void sinkCommit(sink *s, int len);
+
+int sinkFlush(sink *s);
+/* Keeps going until all of `iov` is written to `fd` or there is an error */
+int sinkWritev(int fd, struct iovec *iov, int iovcnt);
+/* Take what has been written to a memory sink, the sink is left empty */
+cstr *sinkDetach(sink *s);
+void sinkRelease(sink *s);
+
+#endif
@@ -0,0 +1,405 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "source.h"
+
+/* Returned by sourceFill for a run that was only whitespace */
+#define SOURCE_BLANK 2
+
+static int sourceGrow(char **data, size_t *size, size_t needed) {
+    char *grown;
+    size_t newsize;
+
+    if (needed <= *size)
+        return SOURCE_OK;
+
+    newsize = *size == 0 ? SOURCE_BLOCK_SIZE : *size;
+    while (newsize < needed)
+        newsize <<= 1;
+
+    if ((grown = realloc(*data, newsize)) == NULL)
+        return SOURCE_ERR_READ;
+
+    *data = grown;
+    *size = newsize;
+    return SOURCE_OK;
+}
+
+static int sourceBlank(char *data, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; ++i)
+        if ((unsigned char)data[i] > 32)
+            return 0;
+    return 1;
+}
+
+/* Read until the block is full or the input ends */
+static int sourceRead(source *src, sourceBlock *block) {
+    ssize_t n;
+
+    while (block->len < block->size) {
+        n = read(src->fd, block->data + block->len, block->size - block->len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return SOURCE_ERR_READ;
+        }
+        if (n == 0) {
+            src->eof = 1;
+            break;
+        }
+        block->len += n;
+    }
+
+    return SOURCE_OK;
+}
+
+/* Find the opening bracket, 0 if the block was only whitespace */
+static int sourceOpen(source *src, sourceBlock *block) {
+    size_t i;
+
+    i = 0;
+    /* The byte order mark can only be at the very start */
+    if (!src->started && block->len >= 3 &&
+            memcmp(block->data, "\xEF\xBB\xBF", 3) == 0)
+        i = 3;
+    src->started = 1;
+
+    while (i < block->len && (unsigned char)block->data[i] <= 32)
+        i++;
+
+    if (i == block->len) {
+        block->len = 0;
+        return 0;
+    }
+
+    if (block->data[i] != '[')
+        return SOURCE_ERR_PARSE;
+
+    src->opened = 1;
+    src->depth = 1;
+    block->start = i + 1;
+    src->scanned = i + 1;
+    return 1;
+}
+
+/**
+ * Scan what has been read since the last call, keeping the last comma
+ * between elements of the array in `boundary` until the closing bracket.
+ * Brackets inside the elements only need counting, the parser checks that
+ * they match.
+ */
+static int sourceScan(source *src, sourceBlock *block) {
+    unsigned char c;
+    size_t i;
+    int found;
+
+    found = 0;
+    for (i = src->scanned; i < block->len; ++i) {
+        c = block->data[i];
+
+        if (src->inString) {
+            if (src->escaped)
+                src->escaped = 0;
+            else if (c == '\\')
+                src->escaped = 1;
+            else if (c == '"')
+                src->inString = 0;
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            src->inString = 1;
+            break;
+        case '[':
+        case '{':
+            src->depth++;
+            break;
+        case ']':
+        case '}':
+            if (--src->depth == 0) {
+                if (c != ']')
+                    return SOURCE_ERR_PARSE;
+                src->closed = 1;
+                src->boundary = i;
+                src->scanned = i + 1;
+                return 1;
+            }
+            break;
+        case ',':
+            if (src->depth == 1) {
+                src->boundary = i;
+                found = 1;
+            }
+            break;
+        }
+    }
+
+    src->scanned = i;
+    return found;
+}
+
+/* Only whitespace may follow the closing bracket */
+static int sourceTrailing(source *src, sourceBlock *block) {
+    if (!sourceBlank(src->carry, src->carryLen))
+        return SOURCE_ERR_PARSE;
+    src->carryLen = 0;
+
+    while (!src->eof) {
+        block->len = 0;
+        if (sourceRead(src, block) == SOURCE_ERR_READ)
+            return SOURCE_ERR_READ;
+        if (!sourceBlank(block->data, block->len))
+            return SOURCE_ERR_PARSE;
+    }
+
+    return SOURCE_END;
+}
+
+/* Fill the block with the next run of records */
+static int sourceFill(source *src, sourceBlock *block) {
+    size_t end, next;
+    int status;
+
+    if (sourceGrow(&block->data, &block->size,
+                src->carryLen + 1) == SOURCE_ERR_READ)
+        return SOURCE_ERR_READ;
+
+    if (src->closed)
+        return sourceTrailing(src, block);
+
+    if (src->eof && src->carryLen == 0) {
+        if (src->format == SOURCE_ARRAY)
+            return SOURCE_ERR_PARSE; /* never closed */
+        return SOURCE_END;
+    }
+
+    /* The carry has already been scanned and holds no boundary */
+    if (src->carryLen > 0)
+        memcpy(block->data, src->carry, src->carryLen);
+    block->len = src->carryLen;
+    block->start = 0;
+    if (src->opened)
+        src->scanned = block->len;
+    src->carryLen = 0;
+
+    for (;;) {
+        if (block->len == block->size && sourceGrow(&block->data,
+                    &block->size, block->size + 1) == SOURCE_ERR_READ)
+            return SOURCE_ERR_READ;
+
+        if (!src->eof && sourceRead(src, block) == SOURCE_ERR_READ)
+            return SOURCE_ERR_READ;
+
+        if (src->format == SOURCE_LINES) {
+            if (src->eof) {
+                end = next = block->len;
+                break;
+            }
+
+            for (end = block->len; end > 0; --end)
+                if (block->data[end - 1] == '\n')
+                    break;
+            if (end > 0) {
+                next = end;
+                break;
+            }
+            continue;
+        }
+
+        if (!src->opened) {
+            if ((status = sourceOpen(src, block)) == SOURCE_ERR_PARSE)
+                return status;
+            if (status == 0) {
+                if (src->eof)
+                    return SOURCE_ERR_PARSE; /* no array */
+                continue;
+            }
+        }
+
+        if ((status = sourceScan(src, block)) == SOURCE_ERR_PARSE)
+            return status;
+        if (status == 1) {
+            /* Leave out the comma or bracket ending the run */
+            end = src->boundary;
+            next = src->boundary + 1;
+            break;
+        }
+        if (src->eof)
+            return SOURCE_ERR_PARSE; /* never closed */
+    }
+
+    if (sourceGrow(&src->carry, &src->carrySize,
+                block->len - next) == SOURCE_ERR_READ)
+        return SOURCE_ERR_READ;
+    if (block->len > next)
+        memcpy(src->carry, block->data + next, block->len - next);
+    src->carryLen = block->len - next;
+    block->end = end;
+
+    if (sourceBlank(block->data + block->start, end - block->start)) {
+        /* Blank lines and an empty array are fine, an empty element is not */
+        if (src->format == SOURCE_ARRAY && (!src->closed || src->records))
+            return SOURCE_ERR_PARSE;
+        return SOURCE_BLANK;
+    }
+
+    src->records = 1;
+    return SOURCE_OK;
+}
+
+static int sourceProduce(source *src, sourceBlock *block) {
+    int status;
+
+    while ((status = sourceFill(src, block)) == SOURCE_BLANK)
+        ;
+    return status;
+}
+
+static void *sourceWorker(void *arg) {
+    source *src = arg;
+    sourceBlock *block;
+    int status;
+
+    for (;;) {
+        pthread_mutex_lock(&src->lock);
+        while (src->filled - src->released == SOURCE_BLOCKS && !src->stop)
+            pthread_cond_wait(&src->space, &src->lock);
+        if (src->stop) {
+            pthread_mutex_unlock(&src->lock);
+            return NULL;
+        }
+        block = &src->blocks[src->filled % SOURCE_BLOCKS];
+        pthread_mutex_unlock(&src->lock);
+
+        status = sourceProduce(src, block);
+
+        pthread_mutex_lock(&src->lock);
+        if (status == SOURCE_OK) {
+            src->filled++;
+        } else {
+            src->done = 1;
+            src->status = status;
+            src->error = errno;
+        }
+        pthread_cond_signal(&src->ready);
+        pthread_mutex_unlock(&src->lock);
+
+        if (status != SOURCE_OK)
+            return NULL;
+    }
+}
+
+int sourceInit(source *src, int fd, int format) {
+    memset(src, 0, sizeof(source));
+    src->fd = fd;
+    src->format = format;
+
+    pthread_mutex_init(&src->lock, NULL);
+    pthread_cond_init(&src->ready, NULL);
+    pthread_cond_init(&src->space, NULL);
+
+    /* Without a thread the reads happen in sourceNext instead */
+    src->threaded = pthread_create(&src->thread, NULL, sourceWorker,
+            src) == 0;
+    return SOURCE_OK;
+}
+
+int sourceNext(source *src, char **run, size_t *len) {
+    sourceBlock *block;
+    int status;
+
+    if (!src->threaded) {
+        if (src->done)
+            return src->status;
+
+        block = &src->blocks[0];
+        if ((status = sourceProduce(src, block)) != SOURCE_OK) {
+            src->done = 1;
+            src->status = status;
+            return status;
+        }
+
+        *run = block->data + block->start;
+        *len = block->end - block->start;
+        return SOURCE_OK;
+    }
+
+    pthread_mutex_lock(&src->lock);
+    if (src->holding) {
+        src->released++;
+        src->holding = 0;
+        pthread_cond_signal(&src->space);
+    }
+
+    while (src->released == src->filled && !src->done)
+        pthread_cond_wait(&src->ready, &src->lock);
+
+    if (src->released < src->filled) {
+        block = &src->blocks[src->released % SOURCE_BLOCKS];
+        src->holding = 1;
+        *run = block->data + block->start;
+        *len = block->end - block->start;
+        status = SOURCE_OK;
+    } else {
+        status = src->status;
+        errno = src->error;
+    }
+    pthread_mutex_unlock(&src->lock);
+
+    return status;
+}
+
+void sourceRelease(source *src) {
+    int i;
+
+    if (src->threaded) {
+        pthread_mutex_lock(&src->lock);
+        src->stop = 1;
+        pthread_cond_signal(&src->space);
+        pthread_mutex_unlock(&src->lock);
+        pthread_join(src->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&src->lock);
+    pthread_cond_destroy(&src->ready);
+    pthread_cond_destroy(&src->space);
+
+    for (i = 0; i < SOURCE_BLOCKS; ++i)
+        free(src->blocks[i].data);
+    free(src->carry);
+}
@@ -0,0 +1,118 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef __SOURCE_H__
+#define __SOURCE_H__
+
+#include <pthread.h>
+#include <stddef.h>
+
+#define SOURCE_OK         1
+#define SOURCE_END        0
+#define SOURCE_ERR_READ  -1
+#define SOURCE_ERR_PARSE -2
+
+/* What the input holds, which decides where it can be cut */
+#define SOURCE_ARRAY 0
+#define SOURCE_LINES 1
+
+/* Blocks in the ring and how much is read in to each at a time */
+#define SOURCE_BLOCKS 4
+#define SOURCE_BLOCK_SIZE (1024 * 1024)
+
+typedef struct sourceBlock {
+    char *data;
+    size_t len;
+    size_t size;
+    /* The run of whole records handed out is [start, end) */
+    size_t start;
+    size_t end;
+} sourceBlock;
+
+/**
+ * Input from a file descriptor that can not be mapped, such as a pipe. A
+ * thread reads it in large blocks in to a ring of SOURCE_BLOCKS buffers while
+ * the caller parses the ones before, so only those blocks are ever held in
+ * memory. Each block is cut after its last whole record, the elements of a
+ * top-level array or the lines of NDJSON, and the rest is carried to the
+ * start of the next block. A block grows if a single record does not fit.
+ *
+ * Only the framing is checked here, the records are left to the parser.
+ */
+typedef struct source {
+    int fd;
+    int format;
+    sourceBlock blocks[SOURCE_BLOCKS];
+
+    /* What followed the run of the last block */
+    char *carry;
+    size_t carryLen;
+    size_t carrySize;
+
+    /* Where the scan of the array is up to */
+    size_t scanned;
+    size_t boundary;
+    int started;
+    int depth;
+    int inString;
+    int escaped;
+    int opened;
+    int closed;
+    int records;
+    int eof;
+
+    /* Blocks made ready by the thread and blocks the caller is done with */
+    unsigned long filled;
+    unsigned long released;
+    int holding;
+    int done;
+    int status;
+    int error;
+    int stop;
+    int threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    pthread_cond_t space;
+} source;
+
+int sourceInit(source *src, int fd, int format);
+
+/**
+ * Hands out the next run of whole records, which stays valid until the next
+ * call. Returns SOURCE_OK, SOURCE_END once the input is used up,
+ * SOURCE_ERR_READ with errno set or SOURCE_ERR_PARSE if the input is not an
+ * array or it is never closed. A run is never only whitespace.
+ */
+int sourceNext(source *src, char **run, size_t *len);
+
+/* Waits for a read in progress to finish */
+void sourceRelease(source *src);
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * jsonchart - A commandline SVG Plotting Tool
+ *
+ * Version 1.0 Janurary 2022
+ *
+ * Copyright (c) 2022, James Barford-Evans
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Columns of doubles mapped to float32 screen co-ordinates with a multiply
+ * and an add per value. The vector kernels narrow two or four doubles at a
+ * time and store them as one vector of floats; every kernel rounds the same
+ * way so which one runs does not change the output.
+ */
+#include <stddef.h>
+
+#include "transform.h"
+#include "simd.h"
+
+#ifdef SIMD_SSE2
+#include <immintrin.h>
+#endif
+
+typedef void transformKernel(const double *values, size_t len, double scale,
+        double offset, float *out);
+
+static void transformAffineScalar(const double *values, size_t len,
+        double scale, double offset, float *out)
+{
+    size_t i;
+
+    for (i = 0; i < len; ++i)
+        out[i] = (float)(values[i] * scale + offset);
+}
+
+#ifdef SIMD_SSE2
+static void transformAffineSSE2(const double *values, size_t len,
+        double scale, double offset, float *out)
+{
+    __m128d s, o, a, b;
+    size_t i;
+
+    s = _mm_set1_pd(scale);
+    o = _mm_set1_pd(offset);
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        a = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(values + i), s), o);
+        b = _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(values + i + 2), s), o);
+        /* Each conversion fills the low two lanes */
+        _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(a),
+                    _mm_cvtpd_ps(b)));
+    }
+
+    transformAffineScalar(values + i, len - i, scale, offset, out + i);
+}
+#endif
+
+#ifdef SIMD_AVX2
+__attribute__((target("avx2")))
+static void transformAffineAVX2(const double *values, size_t len,
+        double scale, double offset, float *out)
+{
+    __m256d s, o, a, b;
+    size_t i;
+
+    s = _mm256_set1_pd(scale);
+    o = _mm256_set1_pd(offset);
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        a = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(values + i), s), o);
+        b = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(values + i + 4), s),
+                o);
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(a));
+        _mm_storeu_ps(out + i + 4, _mm256_cvtpd_ps(b));
+    }
+
+    transformAffineScalar(values + i, len - i, scale, offset, out + i);
+}
+#endif
+
+static transformKernel *const transformKernels[] = {
+    [SIMD_LEVEL_SCALAR] = transformAffineScalar,
+#ifdef SIMD_SSE2
+    [SIMD_LEVEL_SSE2] = transformAffineSSE2,
+#endif
+#ifdef SIMD_AVX2
+    [SIMD_LEVEL_AVX2] = transformAffineAVX2,
+#endif
+};
+
+void transformAffine(const double *values, size_t len, double scale,
+        double offset, float *out)
+{
+    transformKernels[simdLevel()](values, len, scale, offset, out);
+}